@@ -0,0 +1,178 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+#include "Population.h"
+
+// NUMA-aware placement for the OpenMP program and the hybrid MPI build (--bind).
+//
+// Linux and Windows put a page on the NUMA node of the thread that first
+// writes it. bindThreads() pins every OpenMP thread to one of the CPUs the
+// process may run on, so a thread stays next to the pages it touched.
+// firstTouch() then zeroes each population row from the thread that breeds
+// into it under schedule(static). The distance matrix is allocated through
+// UninitializedAllocator, so the threads that build its rows place them, not
+// one thread zero-filling the whole matrix first. With one MPI rank per NUMA
+// node (mpirun --map-by numa --bind-to numa) and --bind close, the tours and
+// distances of every rank stay on its own node.
+
+enum class BindMode {
+    None,   // leave thread placement to the OS
+    Close,  // thread t on the t-th CPU the process may use
+    Spread  // threads spaced evenly over those CPUs
+};
+
+inline const char* bindName(BindMode mode) {
+    switch (mode) {
+    case BindMode::None:   return "none";
+    case BindMode::Close:  return "close";
+    case BindMode::Spread: return "spread";
+    }
+    return "unknown";
+}
+
+inline bool parseBindMode(const std::string& name, BindMode& mode) {
+    for (BindMode candidate : { BindMode::None, BindMode::Close, BindMode::Spread }) {
+        if (name == bindName(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace detail {
+
+// The CPUs the calling thread may run on, e.g. as restricted by mpirun --bind-to.
+inline std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#elif defined(_WIN32)
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+        for (int cpu = 0; cpu < static_cast<int>(8 * sizeof(DWORD_PTR)); ++cpu) {
+            if (processMask & (static_cast<DWORD_PTR>(1) << cpu)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+inline bool pinCurrentThread(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+}  // namespace detail
+
+// Pins thread t of the OpenMP team of numThreads to a CPU of the process's
+// current set; later parallel regions reuse the same threads. Returns the CPU
+// of every thread, or nothing if the mode is None or pinning is unsupported.
+inline std::vector<int> bindThreads(BindMode mode, int numThreads) {
+    std::vector<int> placement;
+#ifdef _OPENMP
+    const std::vector<int> cpus = detail::allowedCpus();
+    if (mode == BindMode::None || cpus.empty() || numThreads < 1) {
+        return placement;
+    }
+    placement.resize(numThreads);
+    for (int t = 0; t < numThreads; ++t) {
+        const size_t slot = mode == BindMode::Close ? t % cpus.size() : static_cast<size_t>(t) * cpus.size() / numThreads;
+        placement[t] = cpus[slot];
+    }
+    bool pinned = true;
+    #pragma omp parallel num_threads(numThreads) reduction(&& : pinned)
+    {
+        pinned = detail::pinCurrentThread(placement[omp_get_thread_num()]);
+    }
+    if (!pinned) {
+        placement.clear();
+    }
+#else
+    (void)mode;
+    (void)numThreads;
+#endif
+    return placement;
+}
+
+// "0,2,4,6", for the run output.
+inline std::string cpuList(const std::vector<int>& cpus) {
+    std::string text;
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        text += (i > 0 ? "," : "") + std::to_string(cpus[i]);
+    }
+    return text;
+}
+
+// Writes every row of both generations from the thread that owns its slot
+// under schedule(static), before anything else touches the population.
+template <typename Index>
+void firstTouch(Population<Index>& population) {
+    const int size = population.size();
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < size; ++i) {
+        std::fill(population[i], population[i] + population.stride(), Index());
+        std::fill(population.next(i), population.next(i) + population.stride(), Index());
+    }
+}
+
+// std::allocator that leaves resized elements uninitialised, so a vector's
+// pages are first written by whoever fills it.
+template <typename T>
+struct UninitializedAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        using other = UninitializedAllocator<U>;
+    };
+
+    UninitializedAllocator() = default;
+    template <typename U>
+    UninitializedAllocator(const UninitializedAllocator<U>&) noexcept {}
+
+    template <typename U>
+    void construct(U* pointer) noexcept {
+        ::new (static_cast<void*>(pointer)) U;
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* pointer, Args&&... args) {
+        ::new (static_cast<void*>(pointer)) U(std::forward<Args>(args)...);
+    }
+};
@@ -0,0 +1,302 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <filesystem>
+#include "Options.h"
+#include "TspLoader.h"
+#include "RunReport.h"
+#include "Termination.h"
+#include "Solver.h"
+#include "WorkStealing.h"
+
+using namespace std;
+
+// Batch driver: solves many instances, for throughput rather than latency.
+//
+//   Batch [batch options] [GA options] (manifest | directory | instance.tsp) ...
+//
+// A directory contributes its *.tsp files; any other file that is not a .tsp
+// is a manifest with one path per line (relative to the manifest, '#'
+// starts a comment). Whole instances are the tasks of a WorkStealingPool of
+// --threads workers, each solving one instance at a time on one core, so a
+// 14-city problem never pays for a thread team. An instance of --large
+// cities or more is set aside when a worker loads it and solved after the
+// pool drains, by all threads at once (OpenMP over the children of a
+// generation). Every child draws from its own random stream, as in
+// OpenMP.cpp, so an instance gets the same tour whichever way it is solved.
+//
+// One row per instance (path, size, threads, generations, seconds, length,
+// stop reason and tour) is written and flushed as soon as it is solved; the
+// summary with the batch's jobs per second goes to stderr. The GA options
+// are those of the other programs; --time-limit and the other stop
+// conditions apply to each instance.
+
+struct BatchResult : SolveResult {
+    string path;
+    string name;
+    int numCities = 0;
+    int threads = 1;
+    double seconds = 0.0;  // loading, precomputation and the GA
+    string error;          // non-empty: the instance could not be solved
+};
+
+// Solves an instance that is already loaded.
+void solveLoaded(const Options& options, int numThreads, const TspInstance& instance, BatchResult& result) {
+    result.name = instance.name;
+    result.numCities = instance.numCities();
+    result.threads = numThreads;
+    solveInstance(options, numThreads, instance, result);
+}
+
+// Rows are written and flushed under a lock as instances finish, in any order.
+class ResultStream {
+public:
+    ResultStream(ostream& out, const string& format) : out_(out), json_(format == "json") {
+        if (!json_) {
+            out_ << "path,name,cities,threads,generations,seconds,best,stop,tour" << endl;
+        }
+    }
+
+    void write(const BatchResult& result) {
+        ostringstream row;
+        row << setprecision(10);
+        if (json_) {
+            row << "{\"path\": \"" << jsonEscape(result.path) << "\", \"name\": \"" << jsonEscape(result.name)
+                << "\", \"cities\": " << result.numCities << ", \"threads\": " << result.threads
+                << ", \"generations\": " << result.generations << ", \"seconds\": " << result.seconds;
+            if (!result.error.empty()) {
+                row << ", \"error\": \"" << jsonEscape(result.error) << "\"}";
+            } else {
+                row << ", \"best\": " << result.length << ", \"stop\": \"" << stopReasonName(result.reason) << "\", \"tour\": [";
+                for (size_t c = 0; c < result.tour.size(); ++c) {
+                    row << (c > 0 ? ", " : "") << result.tour[c];
+                }
+                row << "]}";
+            }
+        } else {
+            row << result.path << ',' << result.name << ',' << result.numCities << ',' << result.threads << ','
+                << result.generations << ',' << result.seconds << ',';
+            if (!result.error.empty()) {
+                row << ",error: " << result.error << ',';
+            } else {
+                row << result.length << ',' << stopReasonName(result.reason) << ',';
+                for (size_t c = 0; c < result.tour.size(); ++c) {
+                    row << (c > 0 ? " " : "") << result.tour[c];
+                }
+            }
+        }
+        lock_guard<mutex> lock(mutex_);
+        out_ << row.str() << endl;
+    }
+
+private:
+    ostream& out_;
+    bool json_;
+    mutex mutex_;
+};
+
+// Expands the command-line inputs into instance paths, in order.
+bool collectInstances(const vector<string>& inputs, vector<string>& paths, string& error) {
+    namespace fs = std::filesystem;
+    for (const string& input : inputs) {
+        std::error_code code;
+        if (fs::is_directory(input, code)) {
+            vector<string> found;
+            for (const fs::directory_entry& entry : fs::directory_iterator(input, code)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".tsp") {
+                    found.push_back(entry.path().string());
+                }
+            }
+            sort(found.begin(), found.end());
+            paths.insert(paths.end(), found.begin(), found.end());
+        } else if (fs::path(input).extension() == ".tsp") {
+            paths.push_back(input);
+        } else {
+            ifstream manifest(input);
+            if (!manifest) {
+                error = "Cannot read the manifest " + input;
+                return false;
+            }
+            const fs::path base = fs::path(input).parent_path();
+            string line;
+            while (getline(manifest, line)) {
+                line.erase(find(line.begin(), line.end(), '#'), line.end());
+                line.erase(0, line.find_first_not_of(" \t\r"));
+                line.erase(line.find_last_not_of(" \t\r") + 1);
+                if (!line.empty()) {
+                    const fs::path path(line);
+                    paths.push_back(path.is_absolute() ? line : (base / path).string());
+                }
+            }
+        }
+        if (code) {
+            error = "Cannot list " + input + ": " + code.message();
+            return false;
+        }
+    }
+    return true;
+}
+
+void printBatchUsage(ostream& out, const char* program) {
+    out << "Usage: " << program << " [options] (manifest | directory | instance.tsp) ...\n"
+        << "  --large N        cities from which an instance is solved by all threads (default 1000)\n"
+        << "  --format NAME    csv or json (JSON lines) (default csv)\n"
+        << "  --out PATH       write the results to PATH instead of stdout\n"
+        << "  --threads N      pool workers, and threads per large instance (default: hardware threads)\n"
+        << "GA options, applied to every instance:\n";
+    ostringstream options;
+    printUsage(options, program);
+    string line;
+    istringstream lines(options.str());
+    getline(lines, line);
+    while (getline(lines, line)) {
+        if (line.find("--instance") == string::npos && line.find("--threads") == string::npos) {
+            out << line << '\n';
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Batch options and inputs are taken out here; the rest are the GA options of Options.h
+    int largeCities = 1000;
+    string format = "csv";
+    string outPath;
+    vector<string> inputs;
+    vector<char*> gaArguments = { argv[0] };
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        if (arg == "--large" || arg == "--format" || arg == "--out") {
+            if (i + 1 >= argc) {
+                cerr << "Missing value for " << arg << endl;
+                printBatchUsage(cerr, argv[0]);
+                return 1;
+            }
+            const string value = argv[++i];
+            bool valid;
+            if (arg == "--large") {
+                valid = detail::parseIntOption(value, 1, largeCities);
+            } else if (arg == "--format") {
+                format = value;
+                valid = format == "csv" || format == "json";
+            } else {
+                outPath = value;
+                valid = !outPath.empty();
+            }
+            if (!valid) {
+                cerr << "Invalid value for " << arg << ": " << value << endl;
+                printBatchUsage(cerr, argv[0]);
+                return 1;
+            }
+        } else if (arg.compare(0, 2, "--") != 0 && arg != "-h") {
+            inputs.push_back(arg);
+        } else {
+            gaArguments.push_back(argv[i]);
+            if (i + 1 < argc && isValueOption(arg)) {
+                gaArguments.push_back(argv[++i]);
+            }
+        }
+    }
+    Options options;
+    string error;
+    if (!parseOptions(static_cast<int>(gaArguments.size()), gaArguments.data(), options, error)) {
+        cerr << error << endl;
+        printBatchUsage(cerr, argv[0]);
+        return 1;
+    }
+    if (options.showHelp) {
+        printBatchUsage(cout, argv[0]);
+        return 0;
+    }
+    // Batch writes its own rows; the per-run report does not apply either
+    const char* unsupported = !options.reportPath.empty() ? "--report" : unsupportedBySolver(options);
+    if (unsupported != nullptr) {
+        cerr << "Batch mode does not support " << unsupported << endl;
+        return 1;
+    }
+    if (inputs.empty()) {
+        cerr << "No instances given" << endl;
+        printBatchUsage(cerr, argv[0]);
+        return 1;
+    }
+
+    vector<string> paths;
+    if (!collectInstances(inputs, paths, error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    ofstream file;
+    if (!outPath.empty()) {
+        file.open(outPath);
+        if (!file) {
+            cerr << "Cannot write " << outPath << endl;
+            return 1;
+        }
+    }
+    ResultStream stream(outPath.empty() ? cout : file, format);
+
+    const int numThreads = options.numThreads > 0 ? options.numThreads : max(1, static_cast<int>(thread::hardware_concurrency()));
+    const auto batchStart = chrono::steady_clock::now();
+
+    // Pool phase: every worker loads and solves whole instances; large ones wait for the team
+    struct Deferred {
+        string path;
+        TspInstance instance;
+        double loadSeconds;
+    };
+    vector<Deferred> large;
+    mutex largeMutex;
+    int failed = 0;
+    WorkStealingPool pool(numThreads);
+    pool.run(static_cast<int>(paths.size()), [&](int, int index) {
+        const auto start = chrono::steady_clock::now();
+        BatchResult result;
+        result.path = paths[index];
+        TspInstance instance;
+        string loadError;
+        if (!loadTspInstance(result.path, instance, loadError, options.useCache)) {
+            result.error = loadError;
+        } else if (instance.numCities() >= largeCities && numThreads > 1) {
+            const double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            lock_guard<mutex> lock(largeMutex);
+            large.push_back({ result.path, move(instance), loadSeconds });
+            return;
+        } else if (instance.numCities() < 3) {
+            result.error = "fewer than 3 cities";
+        } else {
+            solveLoaded(options, 1, instance, result);
+        }
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (!result.error.empty()) {
+            lock_guard<mutex> lock(largeMutex);
+            ++failed;
+        }
+        stream.write(result);
+    });
+
+    // Team phase: one large instance at a time on all threads
+    for (Deferred& deferred : large) {
+        const auto start = chrono::steady_clock::now();
+        BatchResult result;
+        result.path = deferred.path;
+        solveLoaded(options, numThreads, deferred.instance, result);
+        result.seconds = deferred.loadSeconds + chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        stream.write(result);
+        deferred.instance = TspInstance();
+    }
+
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - batchStart).count();
+    cerr << "Batch: " << paths.size() << " instances (" << large.size() << " large) on " << numThreads << " threads in "
+        << seconds << " s, " << (seconds > 0.0 ? paths.size() / seconds : 0.0) << " jobs/s";
+    if (failed > 0) {
+        cerr << ", " << failed << " failed";
+    }
+    cerr << endl;
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,526 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include "TspLoader.h"
+#include "Random.h"
+#include "DistanceCache.h"
+#include "NeighborLists.h"
+#include "Population.h"
+#include "TourKernel.h"
+#include "Crossover.h"
+#include "Mutation.h"
+#include "Tour.h"
+#include "Selection.h"
+#include "Seeding.h"
+#include "Dispatch.h"
+#include "Options.h"
+#include "RunReport.h"
+
+using namespace std;
+using namespace chrono;
+
+// Benchmark suite for the building blocks of the GA.
+//
+//   kernels   the tour-length kernels on TSPLIB instances: every path the CPU
+//             supports, with 32- and 16-bit city indices, with time per edge,
+//             speedup over the scalar path and the largest relative
+//             deviation from it
+//   micro     single distances, tour lengths, each crossover, mutation,
+//             selection and seeding operator on random EUC_2D instances of
+//             several sizes, through the same specialisation the GA picks
+//             (see Dispatch.h), and a random 2-opt move on the array and the
+//             two-level list tour of the local search (see Tour.h); the
+//             neighbour lists are built on the random instance and on cities
+//             along one line, the degenerate case of the spatial grid
+//
+// Every row is a time per unit of work, so lower is better. --format csv or
+// json (one object per line) gives machine-readable rows that scaling.py can
+// compare against a saved baseline.
+//
+//   Benchmark [--suite kernels|micro|all] [--sizes 100,1000,10000] [--min-time S]
+//             [--format table|csv|json] [--out PATH] [instance.tsp ...]
+//
+// The kernel suite runs on pcb3038.tsp and d5000.tsp unless instances are given.
+
+struct Measurement {
+    string section;
+    string instance;
+    int numCities = 0;
+    string name;
+    string unit;
+    double value = 0.0;     // nanoseconds per unit
+    double speedup = 0.0;   // kernels only: over the scalar path
+    double maxError = -1.0; // kernels only: relative to the scalar path
+};
+
+// Where timePerUnit() stores its sums, so the work cannot be optimised away.
+volatile double benchmarkSink = 0.0;
+
+// Calls `op` until at least minSeconds have passed; each call does `units`
+// units of work and returns a value that is summed into benchmarkSink.
+// Returns nanoseconds per unit.
+template <typename Op>
+double timePerUnit(long long units, Op op, double minSeconds) {
+    double sink = 0.0;
+    long long done = 0;
+    auto start = steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        sink += op();
+        done += units;
+        elapsed = duration<double>(steady_clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    benchmarkSink = sink;
+    return elapsed * 1e9 / done;
+}
+
+// Runs `score` over the whole population; returns nanoseconds per edge.
+template <typename Index, typename Score>
+double timePerEdge(const Population<Index>& population, Score score, double minSeconds) {
+    const int numCities = population.numCities();
+    return timePerUnit(static_cast<long long>(population.size()) * numCities, [&]() {
+        double total = 0.0;
+        for (int i = 0; i < population.size(); ++i) {
+            total += score(population[i], numCities);
+        }
+        return total;
+    }, minSeconds);
+}
+
+string instanceName(const string& path) {
+    return path.substr(path.find_last_of("/\\") + 1);
+}
+
+int runKernelSuite(const vector<string>& instances, double minSeconds, vector<Measurement>& results) {
+    const int populationSize = 100;
+    const SimdLevel supported = detectSimdLevel();
+
+    for (const string& path : instances) {
+        TspInstance instance;
+        string error;
+        if (!loadTspInstance(path, instance, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        if (!instance.hasCoordinates() || instance.weightType != EdgeWeightType::Euc2D) {
+            cerr << "Skipping " << path << ": the kernels need EUC_2D coordinates" << endl;
+            continue;
+        }
+        const int numCities = instance.numCities();
+
+        Population<int> population(populationSize, numCities);
+        Rng rng(42);
+        for (int i = 0; i < populationSize; ++i) {
+            int* route = population[i];
+            for (int c = 0; c < numCities; ++c) {
+                route[c] = c;
+            }
+            rng.shuffle(route, numCities);
+        }
+
+        // The same tours with 16-bit indices, as the GA stores them up to 65536 cities
+        const bool narrow = numCities <= kMaxNarrowCities;
+        Population<uint16_t> narrowPopulation(narrow ? populationSize : 0, numCities);
+        for (int i = 0; narrow && i < populationSize; ++i) {
+            copy(population[i], population[i] + numCities, narrowPopulation[i]);
+        }
+
+        DistanceCache distances(instance);
+        TourKernel kernel(instance, distances, SimdLevel::Scalar);
+        const double* x = kernel.x();
+        const double* y = kernel.y();
+        vector<double> reference(populationSize);
+        for (int i = 0; i < populationSize; ++i) {
+            reference[i] = tourLengthScalar<EdgeRounding::Nearest>(x, y, population[i], numCities);
+        }
+
+        auto report = [&](const string& name, double nsPerEdge, double baseline, double maxError) {
+            results.push_back({ "kernels", instanceName(path), numCities, name, "ns/edge", nsPerEdge, baseline / nsPerEdge, maxError });
+        };
+        auto maxRelativeError = [&](auto score) {
+            double worst = 0.0;
+            for (int i = 0; i < populationSize; ++i) {
+                worst = max(worst, fabs(score(population[i], numCities) - reference[i]) / reference[i]);
+                if (narrow) {
+                    worst = max(worst, fabs(score(narrowPopulation[i], numCities) - reference[i]) / reference[i]);
+                }
+            }
+            return worst;
+        };
+
+        auto scalar = [&](const auto* route, int n) { return tourLengthScalar<EdgeRounding::Nearest>(x, y, route, n); };
+        const double scalarTime = timePerEdge(population, scalar, minSeconds);
+        report("scalar", scalarTime, scalarTime, 0.0);
+        if (narrow) {
+            report("scalar/u16", timePerEdge(narrowPopulation, scalar, minSeconds), scalarTime, maxRelativeError(scalar));
+        }
+
+        // Reports `score` on the 32-bit tours and, where they fit, on the 16-bit tours
+        auto run = [&](const string& name, auto score) {
+            report(name, timePerEdge(population, score, minSeconds), scalarTime, maxRelativeError(score));
+            if (narrow) {
+                report(name + "/u16", timePerEdge(narrowPopulation, score, minSeconds), scalarTime, maxRelativeError(score));
+            }
+        };
+
+        auto cached = [&](const auto* route, int n) {
+            double total = distances(route[n - 1], route[0]);
+            for (int c = 0; c + 1 < n; ++c) {
+                total += distances(route[c], route[c + 1]);
+            }
+            return total;
+        };
+        run(distanceLayoutName(distances.layout()), cached);
+
+#ifdef TSP_KERNEL_X86
+        if (supported == SimdLevel::Avx2 || supported == SimdLevel::Avx512) {
+            run("avx2", [&](const auto* route, int n) { return tourLengthAvx2<EdgeRounding::Nearest>(x, y, route, n); });
+        }
+        if (supported == SimdLevel::Avx512) {
+            run("avx512", [&](const auto* route, int n) { return tourLengthAvx512<EdgeRounding::Nearest>(x, y, route, n); });
+        }
+#endif
+    }
+    return 0;
+}
+
+// Cities spread uniformly over a square whose side grows with sqrt(n), so
+// edge lengths stay comparable across sizes.
+TspInstance randomInstance(int numCities, uint64_t seed) {
+    TspInstance instance;
+    instance.name = "random" + to_string(numCities);
+    instance.weightType = EdgeWeightType::Euc2D;
+    const double side = 100.0 * sqrt(static_cast<double>(numCities));
+    Rng rng(seed, numCities);
+    for (int i = 0; i < numCities; ++i) {
+        instance.cities.push_back({ i + 1, rng.uniform() * side, rng.uniform() * side });
+    }
+    instance.prepare(numCities);
+    return instance;
+}
+
+// The same spread of cities on one horizontal line, as in the rows of equal y
+// of d5000 that small clusters of Decompose are cut from.
+TspInstance lineInstance(int numCities, uint64_t seed) {
+    TspInstance instance;
+    instance.name = "line" + to_string(numCities);
+    instance.weightType = EdgeWeightType::Euc2D;
+    const double side = 100.0 * numCities;
+    Rng rng(seed, numCities);
+    for (int i = 0; i < numCities; ++i) {
+        instance.cities.push_back({ i + 1, rng.uniform() * side, 0.0 });
+    }
+    instance.prepare(numCities);
+    return instance;
+}
+
+// One build of the k-nearest-neighbour lists per call.
+void runNeighbors(const TspInstance& instance, double minSeconds, vector<Measurement>& results) {
+    const int numCities = instance.numCities();
+    results.push_back({ "neighbors", instance.name, numCities, "NeighborLists", "ns/city", timePerUnit(numCities, [&]() {
+        NeighborLists neighbors(instance);
+        return static_cast<double>(neighbors.of(0)[0]);
+    }, minSeconds) });
+}
+
+template <typename Index, typename Distance>
+void runMicro(const TspInstance& instance, const DistanceCache& distances, const NeighborLists& neighbors,
+    const TourKernel& tourKernel, const Distance& distance, double minSeconds, vector<Measurement>& results) {
+    const int numCities = instance.numCities();
+    const int populationSize = 100;
+    const Options defaults;
+    auto report = [&](const char* section, const string& name, const char* unit, double value) {
+        results.push_back({ section, instance.name, numCities, name, unit, value });
+    };
+
+    Seeder seeder(instance, neighbors, distances);
+    Population<Index> population(populationSize, numCities);
+    seeder.seed(population, SeedingType::Random, 42, 0);
+    tourKernel.evaluate(population, distance);
+
+    // Single distances over a fixed set of random pairs
+    const int numPairs = 4096;
+    vector<int> pairs(2 * numPairs);
+    Rng pairRng(42, 1);
+    for (int& city : pairs) {
+        city = pairRng.below(numCities);
+    }
+    auto perPair = [&](auto edge) {
+        return timePerUnit(numPairs, [&]() {
+            double total = 0.0;
+            for (int p = 0; p < numPairs; ++p) {
+                total += edge(pairs[2 * p], pairs[2 * p + 1]);
+            }
+            return total;
+        }, minSeconds);
+    };
+    report("distance", "TspInstance::distance", "ns/call", perPair([&](int a, int b) { return instance.distance(a, b); }));
+    const Euc2DMetric metric{ instance.cities.data() };
+    report("distance", Euc2DMetric::name(), "ns/call", perPair(metric));
+    report("distance", string("DistanceCache (") + distanceLayoutName(distances.layout()) + ")", "ns/call",
+        perPair([&](int a, int b) { return distances(a, b); }));
+    report("distance", string("specialised ") + Distance::name(), "ns/call", perPair(distance));
+
+    // Whole tours, as the GA scores every new child
+    report("tour", string("tourLength (") + tourKernel.description() + ")", "ns/edge",
+        timePerEdge(population, [&](const Index* route, int n) { return tourKernel.tourLength(route, n, distance); }, minSeconds));
+
+    // One child per call from alternating parent pairs
+    vector<Index> child(numCities);
+    CrossoverScratch scratch;
+    for (CrossoverType type : { CrossoverType::OX, CrossoverType::PMX, CrossoverType::CX, CrossoverType::ERX }) {
+        Rng rng(42, 2);
+        int pair = 0;
+        report("crossover", crossoverName(type), "ns/child", timePerUnit(1, [&]() {
+            const int parent = pair++ % (populationSize - 1);
+            crossover(type, population[parent], population[parent + 1], child.data(), numCities, scratch, rng);
+            return static_cast<double>(child[0]);
+        }, minSeconds));
+    }
+
+    // One pass over a tour at the default rate, with the incremental length update
+    for (MutationType type : { MutationType::Swap, MutationType::Insertion, MutationType::Inversion, MutationType::Scramble }) {
+        Rng rng(42, 3);
+        copy(population[0], population[0] + numCities, child.data());
+        report("mutation", mutationName(type), "ns/tour", timePerUnit(1, [&]() {
+            return mutate(type, child.data(), numCities, defaults.mutationRate, distance, rng);
+        }, minSeconds));
+    }
+
+    // One 2-opt move between random cities per call, on both tour representations
+    auto perMove = [&](auto& tour) {
+        Rng rng(42, 6);
+        return timePerUnit(1, [&]() {
+            const int a = rng.below(numCities), c = rng.below(numCities);
+            const int b = tour.next(a);
+            if (c != a && c != b) {
+                tour.reverse(b, c);
+            }
+            return static_cast<double>(tour.next(a));
+        }, minSeconds);
+    };
+    copy(population[0], population[0] + numCities, child.data());
+    vector<int> positions;
+    ArrayTour<Index> arrayTour(child.data(), numCities, positions);
+    report("move", "2-opt (array)", "ns/move", perMove(arrayTour));
+    TwoLevelTour twoLevelTour;
+    twoLevelTour.assign(population[0], numCities);
+    report("move", "2-opt (two-level list)", "ns/move", perMove(twoLevelTour));
+
+    // prepare() plus the parents of every child of one generation
+    for (SelectionType type : { SelectionType::Tournament, SelectionType::Rank, SelectionType::Sus, SelectionType::Truncation }) {
+        Selector selector(type, populationSize, defaults.numElites, defaults.tournamentSize);
+        Rng rng(42, 4);
+        report("selection", selectionName(type), "ns/generation", timePerUnit(1, [&]() {
+            selector.prepare(population.lengths(), rng);
+            int total = 0;
+            for (int slot = selector.numElites(); slot < populationSize; ++slot) {
+                int parent1, parent2;
+                selector.parents(slot, rng, parent1, parent2);
+                total += parent1 + parent2;
+            }
+            return static_cast<double>(total);
+        }, minSeconds));
+    }
+
+    // Population initialisation, one tour per call
+    for (SeedingType type : { SeedingType::Random, SeedingType::NearestNeighbor, SeedingType::Greedy,
+                              SeedingType::Hilbert, SeedingType::Mst }) {
+        uint64_t tour = 0;
+        report("seeding", seedingName(type), "ns/tour", timePerUnit(1, [&]() {
+            Rng rng(42, 5, tour++);
+            seeder.build(type, child.data(), rng);
+            return static_cast<double>(child[0]);
+        }, minSeconds));
+    }
+}
+
+int runMicroSuite(const vector<int>& sizes, double minSeconds, vector<Measurement>& results) {
+    for (int numCities : sizes) {
+        const TspInstance instance = randomInstance(numCities, 42);
+        runNeighbors(instance, minSeconds, results);
+        runNeighbors(lineInstance(numCities, 42), minSeconds, results);
+        DistanceCache distances(instance);
+        NeighborLists neighbors(instance);
+        TourKernel tourKernel(instance, distances);
+        dispatchSpecialization(instance, distances, [&](auto index, const auto& distance) {
+            using Index = decltype(index);
+            cerr << instance.name << ": " << specializationName<Index, decay_t<decltype(distance)>>() << endl;
+            runMicro<Index>(instance, distances, neighbors, tourKernel, distance, minSeconds, results);
+            return 0;
+        });
+    }
+    return 0;
+}
+
+string csvField(const string& text) {
+    if (text.find_first_of(",\"") == string::npos) {
+        return text;
+    }
+    string quoted = "\"";
+    for (char c : text) {
+        quoted += c == '"' ? string("\"\"") : string(1, c);
+    }
+    return quoted + "\"";
+}
+
+void writeTable(ostream& out, const vector<Measurement>& results) {
+    string section;
+    for (const Measurement& m : results) {
+        if (m.section != section) {
+            section = m.section;
+            out << endl << "[" << section << "]" << endl;
+            out << left << setw(14) << "instance" << setw(34) << "case" << right << setw(14) << "time" << "  " << "unit";
+            if (section == "kernels") {
+                out << "   " << right << setw(10) << "speedup" << setw(14) << "max rel err";
+            }
+            out << endl;
+        }
+        out << left << setw(14) << m.instance << setw(34) << m.name << right << fixed << setprecision(3) << setw(14) << m.value
+            << "  " << m.unit;
+        if (m.maxError >= 0.0) {
+            out << right << setprecision(2) << setw(9) << m.speedup << "x" << scientific << setw(14) << m.maxError;
+        }
+        out << defaultfloat << endl;
+    }
+    if (!results.empty() && results.front().section == "kernels") {
+        out << endl << "Tolerance: " << kTourKernelTolerance << " relative to the scalar path" << endl;
+    }
+}
+
+void writeCsv(ostream& out, const vector<Measurement>& results) {
+    out << "section,instance,cities,case,unit,value,speedup,max_rel_err" << endl;
+    out << setprecision(10);
+    for (const Measurement& m : results) {
+        out << m.section << "," << csvField(m.instance) << "," << m.numCities << "," << csvField(m.name) << ","
+            << m.unit << "," << m.value << ",";
+        if (m.maxError >= 0.0) {
+            out << m.speedup << "," << m.maxError;
+        } else {
+            out << ",";
+        }
+        out << endl;
+    }
+}
+
+void writeJson(ostream& out, const vector<Measurement>& results) {
+    out << setprecision(10);
+    for (const Measurement& m : results) {
+        out << "{\"section\": \"" << m.section << "\", \"instance\": \"" << jsonEscape(m.instance) << "\", \"cities\": "
+            << m.numCities << ", \"case\": \"" << jsonEscape(m.name) << "\", \"unit\": \"" << m.unit << "\", \"value\": " << m.value;
+        if (m.maxError >= 0.0) {
+            out << ", \"speedup\": " << m.speedup << ", \"max_rel_err\": " << m.maxError;
+        }
+        out << "}" << endl;
+    }
+}
+
+void printBenchmarkUsage(ostream& out, const char* program) {
+    out << "Usage: " << program << " [options] [instance.tsp ...]\n"
+        << "  --suite NAME     kernels, micro or all (default: all)\n"
+        << "  --sizes LIST     city counts of the micro suite (default: 100,1000,10000)\n"
+        << "  --min-time S     seconds spent on each case (default: 0.3)\n"
+        << "  --format NAME    table, csv or json (default: table)\n"
+        << "  --out PATH       write the results to PATH instead of stdout\n";
+}
+
+int main(int argc, char* argv[]) {
+    string suite = "all";
+    string format = "table";
+    string outPath;
+    vector<int> sizes = { 100, 1000, 10000 };
+    double minSeconds = 0.3;
+    vector<string> instances;
+
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printBenchmarkUsage(cout, argv[0]);
+            return 0;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            instances.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            printBenchmarkUsage(cerr, argv[0]);
+            return 1;
+        }
+        const string value = argv[++i];
+        bool valid = true;
+        if (arg == "--suite") {
+            suite = value;
+            valid = suite == "kernels" || suite == "micro" || suite == "all";
+        } else if (arg == "--format") {
+            format = value;
+            valid = format == "table" || format == "csv" || format == "json";
+        } else if (arg == "--out") {
+            outPath = value;
+            valid = !outPath.empty();
+        } else if (arg == "--min-time") {
+            char* end = nullptr;
+            minSeconds = strtod(value.c_str(), &end);
+            valid = end != value.c_str() && *end == '\0' && minSeconds > 0.0;
+        } else if (arg == "--sizes") {
+            sizes.clear();
+            stringstream list(value);
+            string item;
+            while (valid && getline(list, item, ',')) {
+                char* end = nullptr;
+                long size = strtol(item.c_str(), &end, 10);
+                valid = end != item.c_str() && *end == '\0' && size >= 8 && size <= kMaxNarrowCities;
+                sizes.push_back(static_cast<int>(size));
+            }
+            valid = valid && !sizes.empty();
+        } else {
+            cerr << "Unknown option " << arg << endl;
+            printBenchmarkUsage(cerr, argv[0]);
+            return 1;
+        }
+        if (!valid) {
+            cerr << "Invalid value for " << arg << ": " << value << endl;
+            printBenchmarkUsage(cerr, argv[0]);
+            return 1;
+        }
+    }
+    if (instances.empty()) {
+        instances = { "pcb3038.tsp", "d5000.tsp" };
+    }
+
+    cerr << "CPU path: " << simdLevelName(detectSimdLevel()) << endl;
+    vector<Measurement> results;
+    if (suite != "micro" && runKernelSuite(instances, minSeconds, results) != 0) {
+        return 1;
+    }
+    if (suite != "kernels" && runMicroSuite(sizes, minSeconds, results) != 0) {
+        return 1;
+    }
+
+    ofstream file;
+    if (!outPath.empty()) {
+        file.open(outPath);
+        if (!file) {
+            cerr << "Cannot write " << outPath << endl;
+            return 1;
+        }
+    }
+    ostream& out = outPath.empty() ? cout : file;
+    if (format == "csv") {
+        writeCsv(out, results);
+    } else if (format == "json") {
+        writeJson(out, results);
+    } else {
+        writeTable(out, results);
+    }
+    return 0;
+}
@@ -0,0 +1,380 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <ostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "MappedFile.h"
+#include "Population.h"
+#include "Random.h"
+
+// Checkpoint and resume of the GA state (--checkpoint, --resume).
+//
+// Every --checkpoint-interval generations, and at the generation a run stops
+// at, a worker records what it needs to breed on exactly as if it had never
+// stopped: its tours and their cached lengths, its best tour, the generation,
+// its random stream as it was before that generation's selection, and the
+// counters the stop conditions depend on. Encoding is one copy of the
+// population into a buffer; a CheckpointWriter thread writes the buffer to
+// PATH.tmp and renames it over PATH, so the GA never waits for the disk and
+// PATH always holds a complete checkpoint. A worker with a population of its
+// own (a threaded island, an MPI rank) writes one shard, PATH.N, so MPI ranks
+// checkpoint in parallel. --resume maps the file(s) and continues with the
+// recorded generation; a resumed run must use the same instance, seed,
+// population and worker count.
+//
+// File layout (native endianness):
+//   CheckpointHeader, populationSize x numCities Index tours (no row padding),
+//   populationSize x double lengths, bestRouteLength x int32 best tour,
+//   numExtra x uint64 program-specific words (MPI: the stop vote in flight)
+
+struct CheckpointOptions {
+    std::string path;   // empty: no checkpoints
+    int interval = 100; // generations between checkpoints
+    bool resume = false;
+
+    bool enabled() const { return !path.empty(); }
+};
+
+// The state of one worker at the start of `generation`, besides its population.
+struct CheckpointState {
+    int generation = 0;
+    long long evaluations = 0;                 // tours this worker has bred
+    std::vector<int> bestRoute;                // the best tour this worker knows of; may be empty
+    double bestLength = 0.0;
+    double progressBest = 1e300;               // Termination's view, for --stagnation
+    int lastImprovement = 0;
+    Rng rng;                                   // the worker's stream before selection
+    std::vector<uint64_t> extra;
+};
+
+// Which run and worker a checkpoint belongs to; resuming checks all of it.
+struct CheckpointId {
+    std::string instance;
+    int numCities = 0;
+    uint64_t seed = 0;
+    int worker = 0;
+    int numWorkers = 1;
+    int populationSize = 0;  // tours of this worker
+};
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t indexBytes;
+    int32_t numCities;
+    int32_t populationSize;
+    int32_t worker;
+    int32_t numWorkers;
+    int32_t generation;
+    int32_t lastImprovement;
+    uint64_t seed;
+    uint64_t instanceHash;
+    int64_t evaluations;
+    double bestLength;
+    double progressBest;
+    uint64_t rng[4];
+    uint32_t bestRouteLength;
+    uint32_t numExtra;
+};
+
+constexpr char kCheckpointMagic[8] = { 'T', 'S', 'P', 'C', 'K', 'P', 'T', '1' };
+constexpr uint32_t kCheckpointVersion = 1;
+
+// The file of one worker; with one worker, the checkpoint itself.
+inline std::string checkpointShardPath(const std::string& path, int worker, int numWorkers) {
+    return numWorkers > 1 ? path + "." + std::to_string(worker) : path;
+}
+
+inline bool checkpointExists(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fclose(file);
+    return true;
+}
+
+// FNV-1a of the instance name, so a checkpoint of another instance of the same size is refused.
+inline uint64_t checkpointNameHash(const std::string& name) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (unsigned char c : name) {
+        hash = (hash ^ c) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// Writes `bytes` to `path` through PATH.tmp, flushed to the device before the rename.
+inline bool writeFileAtomically(const std::string& path, const std::vector<char>& bytes, std::string& error) {
+    const std::string temporary = path + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        error = "Cannot write the checkpoint " + temporary;
+        return false;
+    }
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && std::fflush(file) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    ok = std::fclose(file) == 0 && ok;
+#ifdef _WIN32
+    if (ok) {
+        std::remove(path.c_str());
+    }
+#endif
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        error = "Cannot write the checkpoint " + path;
+        return false;
+    }
+    return true;
+}
+
+// Background writer shared by the workers of one process. submit() only
+// queues the buffer; a write of the same path still waiting is replaced, as
+// only the newest state matters, so a slow disk never holds up the GA.
+class CheckpointWriter {
+public:
+    CheckpointWriter() = default;
+
+    ~CheckpointWriter() {
+        std::string error;
+        finish(error);
+    }
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    void submit(const std::string& path, std::vector<char>&& bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto queued = std::find_if(queue_.begin(), queue_.end(), [&](const Job& job) { return job.path == path; });
+        if (queued != queue_.end()) {
+            queued->bytes = std::move(bytes);
+        } else {
+            queue_.push_back({ path, std::move(bytes) });
+        }
+        if (!thread_.joinable()) {
+            done_ = false;
+            thread_ = std::thread(&CheckpointWriter::run, this);
+        }
+        wake_.notify_one();
+    }
+
+    // Waits until every submitted checkpoint is on disk; false with the first error otherwise.
+    bool finish(std::string& error) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (!error_.empty()) {
+            error = error_;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Job {
+        std::string path;
+        std::vector<char> bytes;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&] { return done_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            Job job = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+            std::string error;
+            const bool ok = writeFileAtomically(job.path, job.bytes, error);
+            lock.lock();
+            if (!ok && error_.empty()) {
+                error_ = error;
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Job> queue_;
+    bool done_ = false;
+    std::string error_;
+    std::thread thread_;
+};
+
+// One worker's checkpoints: when they are due, and encoding them for the writer.
+class Checkpointer {
+public:
+    // A disabled Checkpointer.
+    Checkpointer() = default;
+
+    Checkpointer(const CheckpointOptions& options, CheckpointWriter& writer, const CheckpointId& id)
+        : enabled_(options.enabled()), interval_(options.interval), writer_(&writer), id_(id),
+          path_(checkpointShardPath(options.path, id.worker, id.numWorkers)) {}
+
+    bool enabled() const { return enabled_; }
+    const CheckpointId& id() const { return id_; }
+    const std::string& path() const { return path_; }
+
+    // Every interval generations, except the one a run starts or resumes with.
+    bool due(int generation, int firstGeneration) const {
+        return enabled_ && generation != firstGeneration && generation % interval_ == 0;
+    }
+
+    template <typename Index>
+    void save(const Population<Index>& population, const CheckpointState& state) {
+        if (!enabled_) {
+            return;
+        }
+        const int size = population.size();
+        const int numCities = population.numCities();
+        CheckpointHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+        header.version = kCheckpointVersion;
+        header.indexBytes = sizeof(Index);
+        header.numCities = numCities;
+        header.populationSize = size;
+        header.worker = id_.worker;
+        header.numWorkers = id_.numWorkers;
+        header.generation = state.generation;
+        header.lastImprovement = state.lastImprovement;
+        header.seed = id_.seed;
+        header.instanceHash = checkpointNameHash(id_.instance);
+        header.evaluations = state.evaluations;
+        header.bestLength = state.bestLength;
+        header.progressBest = state.progressBest;
+        state.rng.state(header.rng);
+        header.bestRouteLength = static_cast<uint32_t>(state.bestRoute.size());
+        header.numExtra = static_cast<uint32_t>(state.extra.size());
+
+        const size_t routeBytes = static_cast<size_t>(numCities) * sizeof(Index);
+        std::vector<char> bytes(sizeof(header) + size * (routeBytes + sizeof(double))
+            + state.bestRoute.size() * sizeof(int32_t) + state.extra.size() * sizeof(uint64_t));
+        char* p = bytes.data();
+        std::memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+        for (int i = 0; i < size; ++i, p += routeBytes) {
+            std::memcpy(p, population[i], routeBytes);
+        }
+        std::memcpy(p, population.lengths(), size * sizeof(double));
+        p += size * sizeof(double);
+        for (int city : state.bestRoute) {
+            const int32_t value = city;
+            std::memcpy(p, &value, sizeof(value));
+            p += sizeof(value);
+        }
+        if (!state.extra.empty()) {
+            std::memcpy(p, state.extra.data(), state.extra.size() * sizeof(uint64_t));
+        }
+        writer_->submit(path_, std::move(bytes));
+    }
+
+private:
+    bool enabled_ = false;
+    int interval_ = 1;
+    CheckpointWriter* writer_ = nullptr;
+    CheckpointId id_;
+    std::string path_;
+};
+
+// A mapped checkpoint file, checked against the run that resumes it.
+class CheckpointFile {
+public:
+    template <typename Index>
+    bool open(const std::string& path, const CheckpointId& id, std::string& error) {
+        if (!file_.open(path)) {
+            error = "Cannot read the checkpoint " + path;
+            return false;
+        }
+        if (file_.size() < sizeof(header_)) {
+            error = path + " is not a checkpoint";
+            return false;
+        }
+        std::memcpy(&header_, file_.data(), sizeof(header_));
+        if (std::memcmp(header_.magic, kCheckpointMagic, sizeof(header_.magic)) != 0 || header_.version != kCheckpointVersion) {
+            error = path + " is not a checkpoint of this version";
+            return false;
+        }
+        if (header_.indexBytes != sizeof(Index) || header_.numCities != id.numCities
+            || header_.instanceHash != checkpointNameHash(id.instance)) {
+            error = path + " is a checkpoint of another instance";
+            return false;
+        }
+        if (header_.seed != id.seed || header_.worker != id.worker || header_.numWorkers != id.numWorkers
+            || header_.populationSize != id.populationSize) {
+            error = path + " is a checkpoint of a run with another seed, population or worker count";
+            return false;
+        }
+        const size_t expected = sizeof(header_)
+            + static_cast<size_t>(header_.populationSize) * (static_cast<size_t>(header_.numCities) * sizeof(Index) + sizeof(double))
+            + header_.bestRouteLength * sizeof(int32_t) + header_.numExtra * sizeof(uint64_t);
+        if (file_.size() != expected || (header_.bestRouteLength != 0 && header_.bestRouteLength != static_cast<uint32_t>(header_.numCities))) {
+            error = path + " is truncated or corrupt";
+            return false;
+        }
+        return true;
+    }
+
+    int generation() const { return header_.generation; }
+
+    // Copies the tours, their lengths and the worker state out of the mapping.
+    template <typename Index>
+    void restore(Population<Index>& population, CheckpointState& state) const {
+        const int size = header_.populationSize;
+        const size_t routeBytes = static_cast<size_t>(header_.numCities) * sizeof(Index);
+        const char* p = file_.data() + sizeof(header_);
+        for (int i = 0; i < size; ++i, p += routeBytes) {
+            std::memcpy(population[i], p, routeBytes);
+        }
+        std::memcpy(population.lengths(), p, size * sizeof(double));
+        p += size * sizeof(double);
+        state.generation = header_.generation;
+        state.evaluations = header_.evaluations;
+        state.bestLength = header_.bestLength;
+        state.progressBest = header_.progressBest;
+        state.lastImprovement = header_.lastImprovement;
+        state.rng.setState(header_.rng);
+        state.bestRoute.resize(header_.bestRouteLength);
+        for (int& city : state.bestRoute) {
+            int32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            city = value;
+            p += sizeof(value);
+        }
+        state.extra.resize(header_.numExtra);
+        if (!state.extra.empty()) {
+            std::memcpy(state.extra.data(), p, state.extra.size() * sizeof(uint64_t));
+        }
+    }
+
+private:
+    MappedFile file_;
+    CheckpointHeader header_;
+};
+
+inline void printResumeReport(std::ostream& out, const std::string& path, int generation) {
+    out << "Resumed: " << path << " at generation " << generation << std::endl;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cmath>
+
+struct City {
+    int id;
+    double x, y;
+};
+
+inline double calculateDistance(const City& city1, const City& city2) {
+    double dx = city1.x - city2.x;
+    double dy = city1.y - city2.y;
+    return sqrt(dx * dx + dy * dy);
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "Random.h"
+
+// Crossover operators for permutation-encoded tours.
+//
+// Every operator runs in O(n): gene membership and gene positions are looked
+// up in a per-worker CrossoverScratch instead of searching the child, and the
+// child is written into a caller-provided buffer so nothing is allocated on
+// the hot path. Keep one scratch and one Rng per thread (or per MPI rank).
+
+enum class CrossoverType {
+    OX,   // Order crossover
+    PMX,  // Partially mapped crossover
+    CX,   // Cycle crossover
+    ERX   // Edge recombination crossover
+};
+
+inline const char* crossoverName(CrossoverType type) {
+    switch (type) {
+    case CrossoverType::OX:  return "ox";
+    case CrossoverType::PMX: return "pmx";
+    case CrossoverType::CX:  return "cx";
+    case CrossoverType::ERX: return "erx";
+    }
+    return "unknown";
+}
+
+inline bool parseCrossoverType(const std::string& name, CrossoverType& type) {
+    for (CrossoverType candidate : { CrossoverType::OX, CrossoverType::PMX, CrossoverType::CX, CrossoverType::ERX }) {
+        if (name == crossoverName(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct CrossoverScratch {
+    // Membership marks: cityMark[c] == stamp means city c is already in the child,
+    // slotMark[i] == stamp means child position i is already filled.
+    std::vector<unsigned> cityMark;
+    std::vector<unsigned> slotMark;
+    unsigned stamp = 0;
+
+    // position[c] = index of city c in one of the parents.
+    std::vector<int> position;
+
+    // ERX adjacency table: up to four neighbours per city.
+    std::vector<int> edges;
+    std::vector<unsigned char> degree;
+
+    void reserve(int numCities) {
+        if (static_cast<int>(cityMark.size()) < numCities) {
+            cityMark.assign(numCities, 0);
+            slotMark.assign(numCities, 0);
+            position.resize(numCities);
+            edges.resize(4 * static_cast<size_t>(numCities));
+            degree.resize(numCities);
+            stamp = 0;
+        }
+    }
+
+    // Starts a new operator call; invalidates all previous marks in O(1).
+    unsigned nextStamp() {
+        if (++stamp == 0) {
+            std::fill(cityMark.begin(), cityMark.end(), 0);
+            std::fill(slotMark.begin(), slotMark.end(), 0);
+            stamp = 1;
+        }
+        return stamp;
+    }
+};
+
+inline void randomSegment(int numCities, int& startPos, int& endPos, Rng& rng) {
+    startPos = rng.below(numCities);
+    endPos = rng.below(numCities);
+    if (startPos > endPos) {
+        std::swap(startPos, endPos);
+    }
+}
+
+// Copies parent1[startPos..endPos] and fills the remaining positions, left to
+// right, with the genes of parent2 in the order they appear there.
+template <typename Index>
+void orderCrossover(const Index* parent1, const Index* parent2, Index* child, int numCities, CrossoverScratch& scratch, Rng& rng) {
+    const unsigned stamp = scratch.nextStamp();
+    int startPos, endPos;
+    randomSegment(numCities, startPos, endPos, rng);
+
+    for (int i = startPos; i <= endPos; ++i) {
+        child[i] = parent1[i];
+        scratch.cityMark[parent1[i]] = stamp;
+    }
+
+    int currentIndex = 0;
+    for (int i = 0; i < numCities; ++i) {
+        if (i == startPos) {
+            i = endPos;
+            continue;
+        }
+        while (scratch.cityMark[parent2[currentIndex]] == stamp) {
+            ++currentIndex;
+        }
+        child[i] = parent2[currentIndex++];
+    }
+}
+
+template <typename Index>
+void partiallyMappedCrossover(const Index* parent1, const Index* parent2, Index* child, int numCities, CrossoverScratch& scratch, Rng& rng) {
+    const unsigned stamp = scratch.nextStamp();
+    int startPos, endPos;
+    randomSegment(numCities, startPos, endPos, rng);
+
+    for (int i = 0; i < numCities; ++i) {
+        scratch.position[parent2[i]] = i;
+    }
+    for (int i = startPos; i <= endPos; ++i) {
+        child[i] = parent1[i];
+        scratch.cityMark[parent1[i]] = stamp;
+        scratch.slotMark[i] = stamp;
+    }
+
+    // Each gene of parent2's segment that is not yet placed follows the mapping
+    // chain out of the segment. The chains are disjoint, so this is linear.
+    for (int i = startPos; i <= endPos; ++i) {
+        Index gene = parent2[i];
+        if (scratch.cityMark[gene] == stamp) {
+            continue;
+        }
+        int k = i;
+        while (k >= startPos && k <= endPos) {
+            k = scratch.position[parent1[k]];
+        }
+        child[k] = gene;
+        scratch.cityMark[gene] = stamp;
+        scratch.slotMark[k] = stamp;
+    }
+
+    for (int i = 0; i < numCities; ++i) {
+        if (scratch.slotMark[i] != stamp) {
+            child[i] = parent2[i];
+        }
+    }
+}
+
+// Alternates whole cycles between the parents; every gene keeps the position
+// it had in one of them.
+template <typename Index>
+void cycleCrossover(const Index* parent1, const Index* parent2, Index* child, int numCities, CrossoverScratch& scratch) {
+    const unsigned stamp = scratch.nextStamp();
+
+    for (int i = 0; i < numCities; ++i) {
+        scratch.position[parent1[i]] = i;
+    }
+
+    bool fromParent1 = true;
+    for (int start = 0; start < numCities; ++start) {
+        if (scratch.slotMark[start] == stamp) {
+            continue;
+        }
+        const Index* source = fromParent1 ? parent1 : parent2;
+        int k = start;
+        do {
+            child[k] = source[k];
+            scratch.slotMark[k] = stamp;
+            k = scratch.position[parent2[k]];
+        } while (k != start);
+        fromParent1 = !fromParent1;
+    }
+}
+
+template <typename Index>
+void edgeRecombinationCrossover(const Index* parent1, const Index* parent2, Index* child, int numCities, CrossoverScratch& scratch, Rng& rng) {
+    const unsigned stamp = scratch.nextStamp();
+    int* edges = scratch.edges.data();
+    unsigned char* degree = scratch.degree.data();
+
+    std::fill(degree, degree + numCities, static_cast<unsigned char>(0));
+    auto addEdge = [&](int a, int b) {
+        int* list = edges + 4 * a;
+        for (int e = 0; e < degree[a]; ++e) {
+            if (list[e] == b) {
+                return;
+            }
+        }
+        list[degree[a]++] = b;
+    };
+    for (const Index* parent : { parent1, parent2 }) {
+        for (int i = 0; i < numCities; ++i) {
+            int a = parent[i];
+            int b = parent[(i + 1) % numCities];
+            addEdge(a, b);
+            addEdge(b, a);
+        }
+    }
+
+    auto removeEdge = [&](int a, int b) {
+        int* list = edges + 4 * a;
+        for (int e = 0; e < degree[a]; ++e) {
+            if (list[e] == b) {
+                list[e] = list[--degree[a]];
+                return;
+            }
+        }
+    };
+
+    // Unreachable cities are picked in parent2 order; the cursor only moves
+    // forward, so the fallback costs O(n) over the whole child.
+    int fallbackCursor = 0;
+    int current = parent1[rng.below(numCities)];
+    for (int i = 0; i < numCities; ++i) {
+        child[i] = static_cast<Index>(current);
+        scratch.cityMark[current] = stamp;
+
+        const int* list = edges + 4 * current;
+        for (int e = 0; e < degree[current]; ++e) {
+            removeEdge(list[e], current);
+        }
+
+        int next = -1;
+        int fewest = 5;
+        for (int e = 0; e < degree[current]; ++e) {
+            int candidate = list[e];
+            if (degree[candidate] < fewest) {
+                fewest = degree[candidate];
+                next = candidate;
+            }
+        }
+        degree[current] = 0;
+
+        if (next == -1 && i + 1 < numCities) {
+            while (scratch.cityMark[parent2[fallbackCursor]] == stamp) {
+                ++fallbackCursor;
+            }
+            next = parent2[fallbackCursor];
+        }
+        current = next;
+    }
+}
+
+template <typename Index>
+void crossover(CrossoverType type, const Index* parent1, const Index* parent2, Index* child, int numCities, CrossoverScratch& scratch, Rng& rng) {
+    scratch.reserve(numCities);
+    switch (type) {
+    case CrossoverType::OX:
+        orderCrossover(parent1, parent2, child, numCities, scratch, rng);
+        break;
+    case CrossoverType::PMX:
+        partiallyMappedCrossover(parent1, parent2, child, numCities, scratch, rng);
+        break;
+    case CrossoverType::CX:
+        cycleCrossover(parent1, parent2, child, numCities, scratch);
+        break;
+    case CrossoverType::ERX:
+        edgeRecombinationCrossover(parent1, parent2, child, numCities, scratch, rng);
+        break;
+    }
+}
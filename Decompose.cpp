@@ -0,0 +1,267 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <omp.h>
+#include "Options.h"
+#include "TspLoader.h"
+#include "Random.h"
+#include "DistanceCache.h"
+#include "NeighborLists.h"
+#include "LocalSearch.h"
+#include "Dispatch.h"
+#include "RunReport.h"
+#include "Termination.h"
+#include "Solver.h"
+#include "Decomposition.h"
+#include "WorkStealing.h"
+
+using namespace std;
+
+// Partition-and-stitch solver for instances of 100k cities and more.
+//
+//   Decompose [--cluster-size N] [--no-refine] [GA options] instance.tsp
+//
+// The cities are cut into clusters of at most --cluster-size by a k-d split
+// (Decomposition.h). Every cluster is an instance of its own, solved on one
+// thread by the GA of Solver.h as one task of a WorkStealingPool of --threads
+// workers, so the GA holds population x cluster-size cities per worker rather
+// than population x n. The cluster tours are joined up the k-d tree at their
+// cheapest boundary edges, and a final 2-opt/Or-opt pass over neighbour
+// lists repairs the seams. Distances of the whole instance are computed on
+// the fly; nothing outside the clusters is quadratic.
+//
+// The GA options apply to every cluster. The budgets --time-limit and
+// --max-evaluations are shared out evenly between the clusters; --target,
+// --engine steady and the checkpoint, trace and tour hashing options are
+// rejected.
+
+struct ClusterResult {
+    int generations = 0;
+    StopReason reason = StopReason::None;
+    double length = 0.0;
+};
+
+// 2-opt/Or-opt over the whole stitched tour; returns the change in length.
+template <typename Index, typename Distance>
+double refine(vector<int>& tour, const NeighborLists& neighbors, const Distance& distance) {
+    const int numCities = static_cast<int>(tour.size());
+    vector<Index> route(tour.begin(), tour.end());
+    LocalSearch localSearch;
+    const double delta = localSearch.improve(route.data(), numCities, neighbors, distance);
+    tour.assign(route.begin(), route.end());
+    return delta;
+}
+
+void printDecomposeUsage(ostream& out, const char* program) {
+    out << "Usage: " << program << " [options] instance.tsp\n"
+        << "  --cluster-size N  most cities per cluster (default 200)\n"
+        << "  --no-refine       skip the 2-opt/Or-opt pass over the stitched tour\n"
+        << "  --threads N       clusters solved at once (default: hardware threads)\n"
+        << "GA options, applied to every cluster:\n";
+    ostringstream options;
+    printUsage(options, program);
+    string line;
+    istringstream lines(options.str());
+    getline(lines, line);
+    while (getline(lines, line)) {
+        if (line.find("--threads") == string::npos && line.find("--bind") == string::npos) {
+            out << line << '\n';
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Decomposition options are taken out here; the rest are the GA options of Options.h
+    int clusterSize = 200;
+    bool refineTour = true;
+    vector<char*> gaArguments = { argv[0] };
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        if (arg == "--cluster-size") {
+            if (i + 1 >= argc || !detail::parseIntOption(argv[i + 1], 8, clusterSize)) {
+                cerr << "Invalid value for " << arg << (i + 1 < argc ? string(": ") + argv[i + 1] : string()) << endl;
+                printDecomposeUsage(cerr, argv[0]);
+                return 1;
+            }
+            ++i;
+        } else if (arg == "--no-refine") {
+            refineTour = false;
+        } else {
+            gaArguments.push_back(argv[i]);
+        }
+    }
+    Options options;
+    string error;
+    if (!parseOptions(static_cast<int>(gaArguments.size()), gaArguments.data(), options, error)) {
+        cerr << error << endl;
+        printDecomposeUsage(cerr, argv[0]);
+        return 1;
+    }
+    if (options.showHelp) {
+        printDecomposeUsage(cout, argv[0]);
+        return 0;
+    }
+    // A target length is meaningless for a single cluster
+    const char* unsupported = options.targetLength > 0.0 ? "--target" : unsupportedBySolver(options);
+    if (unsupported != nullptr) {
+        cerr << "Decomposition does not support " << unsupported << endl;
+        return 1;
+    }
+
+    const string LIGHT_BLUE = "\033[94m";
+    const string GREEN = "\033[32m";
+    const string YELLOW = "\033[33m";
+    const string RESET = "\033[0m";
+
+    cout << GREEN + "================================================" + RESET << endl;
+    cout << GREEN + "           TRAVELING SALESMAN PROBLEM     " + RESET << endl;
+    cout << GREEN + "================================================" + RESET << endl << endl;
+
+    auto startTime = chrono::steady_clock::now();
+    installInterruptHandler();
+
+    TspInstance instance;
+    bool fromCache = false;
+    auto loadStart = chrono::steady_clock::now();
+    if (!loadTspInstance(options.instancePath, instance, error, options.useCache, true, &fromCache)) {
+        cerr << error << endl;
+        return 1;
+    }
+    double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - loadStart).count();
+    const int numCities = instance.numCities();
+    if (!instance.hasCoordinates() || instance.weightType == EdgeWeightType::Explicit) {
+        cerr << "Decomposition needs city coordinates; " << instance.name << " is "
+            << edgeWeightTypeName(instance.weightType) << endl;
+        return 1;
+    }
+    if (numCities < 3) {
+        cerr << instance.name << " has fewer than 3 cities" << endl;
+        return 1;
+    }
+
+    // The whole instance only needs linear-size structures: no distance table, k neighbours per city.
+    // Its OpenMP regions use --threads threads, as the clusters do in total (see solveInstance)
+    const int numThreads = options.numThreads > 0 ? options.numThreads : max(1, static_cast<int>(thread::hardware_concurrency()));
+    omp_set_num_threads(numThreads);
+    DistanceCache distances(instance, DistanceLayout::OnTheFly);
+    NeighborLists neighbors(instance);
+    cout << LIGHT_BLUE << "Instance: " << instance.name << " (" << numCities << " cities, "
+        << edgeWeightTypeName(instance.weightType) << "), loaded in " << loadSeconds * 1000.0 << " ms"
+        << (fromCache ? " from cache" : "") << endl;
+    cout << "Neighbor lists: k = " << neighbors.k() << ", " << neighbors.memoryBytes() / 1048576.0
+        << " MB, built in " << neighbors.buildSeconds() * 1000.0 << " ms" << endl;
+
+    auto partitionStart = chrono::steady_clock::now();
+    SpatialPartition partition(instance.cities, clusterSize);
+    const int numClusters = partition.numClusters();
+    cout << "Decomposition: " << numClusters << " clusters of at most " << clusterSize << " cities (k-d split) in "
+        << chrono::duration<double>(chrono::steady_clock::now() - partitionStart).count() * 1000.0 << " ms, "
+        << numThreads << " threads" << RESET << endl;
+
+    // Every cluster gets its own seed and an even share of the run's budgets
+    Options clusterOptions = options;
+    if (options.stop.timeLimit > 0.0) {
+        const double left = options.stop.timeLimit - chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        clusterOptions.stop.timeLimit = max(left, 1e-3) * min(numThreads, numClusters) / numClusters;
+    }
+    if (options.stop.maxEvaluations > 0) {
+        clusterOptions.stop.maxEvaluations = max(1LL, options.stop.maxEvaluations / numClusters);
+    }
+
+    vector<vector<int>> tours(numClusters);
+    vector<ClusterResult> results(numClusters);
+    auto gaStart = chrono::steady_clock::now();
+    WorkStealingPool pool(numThreads);
+    pool.run(numClusters, [&](int, int c) {
+        const int* members = partition.cluster(c);
+        const int count = partition.clusterSize(c);
+        const TspInstance part = clusterInstance(instance, members, count, c);
+        Options partOptions = clusterOptions;
+        uint64_t state = options.seed + static_cast<uint64_t>(c);
+        partOptions.seed = splitMix64(state);
+        SolveResult solved;
+        solveInstance(partOptions, 1, part, solved);
+        tours[c].resize(count);
+        for (int t = 0; t < count; ++t) {
+            tours[c][t] = members[solved.tour[t]];
+        }
+        results[c] = { solved.generations, solved.reason, solved.length };
+    });
+    double gaSeconds = chrono::duration<double>(chrono::steady_clock::now() - gaStart).count();
+    double clusterLength = 0.0;
+    int maxGenerations = 0;
+    int stopCounts[static_cast<int>(StopReason::Interrupted) + 1] = {};
+    for (const ClusterResult& result : results) {
+        clusterLength += result.length;
+        maxGenerations = max(maxGenerations, result.generations);
+        ++stopCounts[static_cast<int>(result.reason)];
+    }
+    // The run report records the reason that ended the most clusters
+    int mostCommon = 0;
+    for (int r = 1; r <= static_cast<int>(StopReason::Interrupted); ++r) {
+        if (stopCounts[r] > stopCounts[mostCommon]) {
+            mostCommon = r;
+        }
+    }
+    const StopReason clusterReason = static_cast<StopReason>(mostCommon);
+    cout << LIGHT_BLUE << "Clusters: solved in " << gaSeconds << " s, up to " << maxGenerations
+        << " generations, cluster tours total " << clusterLength << RESET << endl;
+    cout << LIGHT_BLUE << "Cluster stops:";
+    for (int r = 0; r <= static_cast<int>(StopReason::Interrupted); ++r) {
+        if (stopCounts[r] > 0) {
+            cout << " " << stopReasonName(static_cast<StopReason>(r)) << " " << stopCounts[r];
+        }
+    }
+    cout << RESET << endl;
+
+    auto stitchStart = chrono::steady_clock::now();
+    TourStitcher stitcher(instance, neighbors);
+    double bestDistance = clusterLength;
+    vector<int> bestRoute = partition.merge(tours, [&](const vector<int>& left, const vector<int>& right, vector<int>& joined) {
+        bestDistance += stitcher.stitch(left, right, joined);
+    });
+    cout << LIGHT_BLUE << "Stitching: " << numClusters - 1 << " joins (" << stitcher.fallbacks()
+        << " beyond the neighbour lists), " << bestDistance << " after stitching, in "
+        << chrono::duration<double>(chrono::steady_clock::now() - stitchStart).count() * 1000.0 << " ms" << RESET << endl;
+
+    if (refineTour) {
+        auto refineStart = chrono::steady_clock::now();
+        double delta = 0.0;
+        dispatchSpecialization(instance, distances, [&](auto index, const auto& distance) {
+            delta = refine<decltype(index)>(bestRoute, neighbors, distance);
+            return 0;
+        });
+        bestDistance += delta;
+        cout << LIGHT_BLUE << "Refinement: 2-opt/Or-opt, " << delta << " in "
+            << chrono::duration<double>(chrono::steady_clock::now() - refineStart).count() * 1000.0 << " ms" << RESET << endl;
+    }
+
+    cout << YELLOW + "\nResults:" + RESET << endl;
+    cout << LIGHT_BLUE + "Best route:\n";
+    for (int city : bestRoute) {
+        cout << city << " ";
+    }
+    cout << RESET << "\n\n";
+    cout << GREEN << "Total distance: " << bestDistance << RESET << endl;
+
+    double duration = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    cout << YELLOW + "Time taken by function: " << duration << " seconds" + RESET << endl;
+
+    if (!options.reportPath.empty()) {
+        RunReport report{ "decompose", instance.name, numCities, numThreads, options.populationSize, maxGenerations,
+            options.seed, duration, gaSeconds, bestDistance, -1.0, stopReasonName(clusterReason) };
+        if (!appendRunReport(options.reportPath, report, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+    }
+
+    cout << GREEN + "\nThank you for using the Genetic Algorithm TSP Solver!" + RESET << endl;
+    cout << GREEN + "===========================================" + RESET << endl;
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <limits>
+#include "TspInstance.h"
+#include "NeighborLists.h"
+
+// Partition-and-stitch for instances too large to evolve whole (Decompose.cpp).
+//
+// SpatialPartition cuts the plane k-d style: a box of more than maxCities
+// cities is split at the median of its wider side, so the clusters are
+// compact, balanced and found in O(n log n). Each cluster becomes an instance
+// of its own (clusterInstance) and is solved by the GA; the cluster tours are
+// then joined back up the same tree, sibling by sibling, by TourStitcher.
+//
+// A join removes one edge from each tour and reconnects the two paths with
+// two new edges. Only pairs of cities that are within each other's neighbour
+// lists are tried, which confines the search to the boundary between the two
+// boxes and keeps a join linear in the size of the tours. Nothing here is
+// per individual: the partition, the stitcher and the joined tour are O(n).
+
+class SpatialPartition {
+public:
+    SpatialPartition(const std::vector<City>& cities, int maxCities) : cities_(cities) {
+        const int n = static_cast<int>(cities.size());
+        order_.resize(n);
+        for (int i = 0; i < n; ++i) {
+            order_[i] = i;
+        }
+        if (n > 0) {
+            split(0, n, std::max(maxCities, 1));
+        }
+    }
+
+    int numClusters() const { return static_cast<int>(leaves_.size()); }
+    const int* cluster(int c) const { return &order_[nodes_[leaves_[c]].begin]; }
+    int clusterSize(int c) const { return nodes_[leaves_[c]].end - nodes_[leaves_[c]].begin; }
+
+    // Joins the tours of all clusters (global city numbers) with join(left,
+    // right, joined), children before parents, and returns the tour of the
+    // whole instance. Consumes `tours`.
+    template <typename Join>
+    std::vector<int> merge(std::vector<std::vector<int>>& tours, Join join) const {
+        std::vector<std::vector<int>> nodeTours(nodes_.size());
+        for (int c = 0; c < numClusters(); ++c) {
+            nodeTours[leaves_[c]].swap(tours[c]);
+        }
+        // Children are always created after their parent, so a reverse scan is a post-order
+        for (int node = static_cast<int>(nodes_.size()) - 1; node >= 0; --node) {
+            const Node& box = nodes_[node];
+            if (box.left >= 0) {
+                join(nodeTours[box.left], nodeTours[box.right], nodeTours[node]);
+                std::vector<int>().swap(nodeTours[box.left]);
+                std::vector<int>().swap(nodeTours[box.right]);
+            }
+        }
+        return nodes_.empty() ? std::vector<int>() : std::move(nodeTours[0]);
+    }
+
+private:
+    struct Node {
+        int begin, end;    // range of order_
+        int left, right;   // children, -1 for a cluster
+    };
+
+    int split(int begin, int end, int maxCities) {
+        const int node = static_cast<int>(nodes_.size());
+        nodes_.push_back({ begin, end, -1, -1 });
+        if (end - begin <= maxCities) {
+            leaves_.push_back(node);
+            return node;
+        }
+        double minX = cities_[order_[begin]].x, maxX = minX;
+        double minY = cities_[order_[begin]].y, maxY = minY;
+        for (int i = begin; i < end; ++i) {
+            const City& city = cities_[order_[i]];
+            minX = std::min(minX, city.x);
+            maxX = std::max(maxX, city.x);
+            minY = std::min(minY, city.y);
+            maxY = std::max(maxY, city.y);
+        }
+        // Ties are broken on the city number, so the split does not depend on the library's nth_element
+        const bool byX = maxX - minX >= maxY - minY;
+        const int middle = begin + (end - begin) / 2;
+        std::nth_element(order_.begin() + begin, order_.begin() + middle, order_.begin() + end, [&](int a, int b) {
+            const double ka = byX ? cities_[a].x : cities_[a].y, kb = byX ? cities_[b].x : cities_[b].y;
+            return ka < kb || (ka == kb && a < b);
+        });
+        const int left = split(begin, middle, maxCities);
+        const int right = split(middle, end, maxCities);
+        nodes_[node].left = left;
+        nodes_[node].right = right;
+        return node;
+    }
+
+    const std::vector<City>& cities_;
+    std::vector<int> order_;    // city numbers, every cluster contiguous
+    std::vector<Node> nodes_;   // the k-d tree, root first
+    std::vector<int> leaves_;   // nodes that are clusters, left to right
+};
+
+// The instance made of `count` cities of `instance`; city i of the result is
+// members[i] of the original. Needs coordinates (not EXPLICIT).
+inline TspInstance clusterInstance(const TspInstance& instance, const int* members, int count, int cluster) {
+    TspInstance part;
+    part.name = instance.name + "/" + std::to_string(cluster);
+    part.weightType = instance.weightType;
+    part.cities.resize(count);
+    for (int i = 0; i < count; ++i) {
+        part.cities[i] = instance.cities[members[i]];
+        part.cities[i].id = i + 1;
+    }
+    part.prepare(count);
+    return part;
+}
+
+class TourStitcher {
+public:
+    TourStitcher(const TspInstance& instance, const NeighborLists& neighbors)
+        : instance_(instance), neighbors_(neighbors), position_(instance.numCities()), side_(instance.numCities(), 0) {}
+
+    int fallbacks() const { return fallbacks_; }
+
+    // Joins the disjoint cycles `a` and `b` into `joined` at the cheapest pair
+    // of edges found and returns the change in total length.
+    double stitch(const std::vector<int>& a, const std::vector<int>& b, std::vector<int>& joined) {
+        mark(a, 1);
+        mark(b, 2);
+        Join best;
+        for (int i = 0; i < static_cast<int>(a.size()); ++i) {
+            const int* near = neighbors_.of(a[i]);
+            for (int j = 0; j < neighbors_.k(); ++j) {
+                if (side_[near[j]] == 2) {
+                    consider(a, b, i, position_[near[j]], best);
+                }
+            }
+        }
+        if (best.delta == kNone) {
+            // The boxes are farther apart than any neighbour list reaches: pair every city with its nearest across
+            ++fallbacks_;
+            if (!grid_) {
+                grid_.reset(new SpatialGrid(instance_.cities));
+            }
+            for (int i = 0; i < static_cast<int>(a.size()); ++i) {
+                const City& city = instance_.cities[a[i]];
+                const int c = grid_->nearest(city.x, city.y, [&](int other) { return side_[other] == 2; });
+                consider(a, b, i, position_[c], best);
+            }
+        }
+        mark(a, 0);
+        mark(b, 0);
+
+        // a from the other end of the removed edge round to a[i], then b from b[j] round to the other end of its edge
+        const int sizeA = static_cast<int>(a.size()), sizeB = static_cast<int>(b.size());
+        joined.resize(sizeA + sizeB);
+        for (int t = 1; t <= sizeA; ++t) {
+            joined[t - 1] = a[best.forwardA ? (best.i + t) % sizeA : (best.i - t % sizeA + sizeA) % sizeA];
+        }
+        for (int t = 0; t < sizeB; ++t) {
+            joined[sizeA + t] = b[best.forwardB ? (best.j - t + sizeB) % sizeB : (best.j + t) % sizeB];
+        }
+        return best.delta;
+    }
+
+private:
+    static constexpr double kNone = std::numeric_limits<double>::max();
+
+    // Remove (a[i], x) and (b[j], y), add (a[i], b[j]) and (x, y); forward: x or y follows in its tour.
+    struct Join {
+        double delta = kNone;
+        int i = 0, j = 0;
+        bool forwardA = true, forwardB = true;
+    };
+
+    void mark(const std::vector<int>& tour, char side) {
+        for (int t = 0; t < static_cast<int>(tour.size()); ++t) {
+            position_[tour[t]] = t;
+            side_[tour[t]] = side;
+        }
+    }
+
+    void consider(const std::vector<int>& a, const std::vector<int>& b, int i, int j, Join& best) const {
+        const int sizeA = static_cast<int>(a.size()), sizeB = static_cast<int>(b.size());
+        const int cityA = a[i], cityB = b[j];
+        const double bridge = instance_.distance(cityA, cityB);
+        for (bool forwardA : { true, false }) {
+            const int x = a[forwardA ? (i + 1) % sizeA : (i - 1 + sizeA) % sizeA];
+            for (bool forwardB : { true, false }) {
+                const int y = b[forwardB ? (j + 1) % sizeB : (j - 1 + sizeB) % sizeB];
+                const double delta = bridge + instance_.distance(x, y) - instance_.distance(cityA, x)
+                    - instance_.distance(cityB, y);
+                if (delta < best.delta) {
+                    best = { delta, i, j, forwardA, forwardB };
+                }
+            }
+        }
+    }
+
+    const TspInstance& instance_;
+    const NeighborLists& neighbors_;
+    std::vector<int> position_;   // index of each city in its tour, valid while marked
+    std::vector<char> side_;      // 1: in a, 2: in b, 0: neither
+    std::unique_ptr<SpatialGrid> grid_;
+    int fallbacks_ = 0;
+};
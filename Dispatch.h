@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "TspInstance.h"
+#include "DistanceCache.h"
+#include "Metric.h"
+
+// Picks the specialisation of the GA once, right after loading:
+//
+//   index type   uint16_t up to kMaxNarrowCities cities, else uint32_t;
+//                halves the bytes of every stored tour on all TSPLIB
+//                instances we ship
+//   distance     the table view for a Dense or PackedFloat cache, otherwise
+//                the metric policy of the instance (see Metric.h)
+//
+// body(Index(), distance) is called with both as template arguments, e.g.
+//
+//   return dispatchSpecialization(instance, distances, [&](auto index, const auto& distance) {
+//       return run<decltype(index)>(..., distance);
+//   });
+//
+// so the hot loops inline the distance and see no branch on the layout or
+// the weight type. Every body instantiation must return int.
+
+constexpr int kMaxNarrowCities = 65536;
+
+template <typename Index>
+inline const char* indexTypeName();
+
+template <>
+inline const char* indexTypeName<uint16_t>() { return "uint16"; }
+
+template <>
+inline const char* indexTypeName<uint32_t>() { return "uint32"; }
+
+// e.g. "uint16 tours, dense distances"
+template <typename Index, typename Distance>
+std::string specializationName() {
+    return std::string(indexTypeName<Index>()) + " tours, " + Distance::name() + " distances";
+}
+
+template <typename Index, typename Body>
+int dispatchDistance(const TspInstance& instance, const DistanceCache& distances, Body& body) {
+    switch (distances.layout()) {
+    case DistanceLayout::Dense:
+        return body(Index(), distances.dense());
+    case DistanceLayout::PackedFloat:
+        return body(Index(), distances.packed());
+    case DistanceLayout::OnTheFly:
+        break;
+    }
+    switch (instance.weightType) {
+    case EdgeWeightType::Euc2D:
+        return body(Index(), Euc2DMetric{ instance.cities.data() });
+    case EdgeWeightType::Ceil2D:
+        return body(Index(), Ceil2DMetric{ instance.cities.data() });
+    case EdgeWeightType::Att:
+        return body(Index(), AttMetric{ instance.cities.data() });
+    case EdgeWeightType::Geo:
+        return body(Index(), GeoMetric{ instance.latitude.data(), instance.longitude.data() });
+    case EdgeWeightType::Explicit:
+        break;
+    }
+    return body(Index(), ExplicitMetric{ instance.weights.data(), instance.numCities() });
+}
+
+template <typename Body>
+int dispatchSpecialization(const TspInstance& instance, const DistanceCache& distances, Body body) {
+    if (instance.numCities() <= kMaxNarrowCities) {
+        return dispatchDistance<uint16_t>(instance, distances, body);
+    }
+    return dispatchDistance<uint32_t>(instance, distances, body);
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
+#include "TspInstance.h"
+#include "Affinity.h"
+
+// Distance oracle shared by evaluation, mutation and local search.
+//
+// The layout is picked from the instance size:
+//   Dense       n <= kDenseMaxCities   full n x n matrix of doubles
+//   PackedFloat n <= kPackedMaxCities  upper triangle stored as float32
+//   OnTheFly    larger instances       computed by TspInstance::distance()
+// EXPLICIT instances already hold their matrix and always use OnTheFly.
+// The object is read-only after construction and can be shared by threads;
+// it keeps a reference to `instance`, which must outlive it.
+
+enum class DistanceLayout { Dense, PackedFloat, OnTheFly };
+
+inline const char* distanceLayoutName(DistanceLayout layout) {
+    switch (layout) {
+    case DistanceLayout::Dense:       return "dense";
+    case DistanceLayout::PackedFloat: return "packed-float32";
+    case DistanceLayout::OnTheFly:    return "on-the-fly";
+    }
+    return "unknown";
+}
+
+// Branch-free views of the two tables, for code specialised on the distance
+// type (see Dispatch.h); DistanceCache::operator() switches on the layout.
+struct DenseDistance {
+    const double* matrix;
+    int numCities;
+
+    static const char* name() { return "dense"; }
+    double operator()(int a, int b) const { return matrix[static_cast<size_t>(a) * numCities + b]; }
+};
+
+struct PackedDistance {
+    const float* packed;
+    const int64_t* rowBase;
+
+    static const char* name() { return "packed-float32"; }
+    double operator()(int a, int b) const {
+        if (a == b) {
+            return 0.0;
+        }
+        if (a > b) {
+            std::swap(a, b);
+        }
+        return packed[rowBase[a] + b];
+    }
+};
+
+class DistanceCache {
+public:
+    static constexpr int kDenseMaxCities = 2048;    // 32 MB
+    static constexpr int kPackedMaxCities = 12000;  // 288 MB; TSPLIB weights are integral, so float32 is exact
+
+    static DistanceLayout chooseLayout(const TspInstance& instance) {
+        const int numCities = instance.numCities();
+        if (instance.weightType == EdgeWeightType::Explicit) {
+            return DistanceLayout::OnTheFly;
+        }
+        if (numCities <= kDenseMaxCities) {
+            return DistanceLayout::Dense;
+        }
+        if (numCities <= kPackedMaxCities) {
+            return DistanceLayout::PackedFloat;
+        }
+        return DistanceLayout::OnTheFly;
+    }
+
+    explicit DistanceCache(const TspInstance& instance)
+        : DistanceCache(instance, chooseLayout(instance)) {}
+
+    DistanceCache(const TspInstance& instance, DistanceLayout layout)
+        : instance_(instance), numCities_(instance.numCities()), layout_(layout) {
+        auto start = std::chrono::steady_clock::now();
+        const int n = numCities_;
+
+        if (layout_ == DistanceLayout::Dense) {
+            dense_.resize(static_cast<size_t>(n) * n);
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 16)
+#endif
+            for (int a = 0; a < n; ++a) {
+                double* row = &dense_[static_cast<size_t>(a) * n];
+                for (int b = 0; b < n; ++b) {
+                    row[b] = instance_.distance(a, b);
+                }
+            }
+        } else if (layout_ == DistanceLayout::PackedFloat) {
+            // Row a holds the distances to cities a+1 .. n-1; rowBase_[a] + b is the slot of (a, b).
+            rowBase_.resize(n);
+            int64_t offset = 0;
+            for (int a = 0; a < n; ++a) {
+                rowBase_[a] = offset - a - 1;
+                offset += n - a - 1;
+            }
+            packed_.resize(static_cast<size_t>(offset));
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 16)
+#endif
+            for (int a = 0; a < n; ++a) {
+                float* row = &packed_[rowBase_[a] + a + 1];
+                for (int b = a + 1; b < n; ++b) {
+                    row[b - a - 1] = static_cast<float>(instance_.distance(a, b));
+                }
+            }
+        }
+
+        buildSeconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double operator()(int a, int b) const {
+        switch (layout_) {
+        case DistanceLayout::Dense:
+            return dense()(a, b);
+        case DistanceLayout::PackedFloat:
+            return packed()(a, b);
+        case DistanceLayout::OnTheFly:
+            break;
+        }
+        return instance_.distance(a, b);
+    }
+
+    // Only valid for the matching layout().
+    DenseDistance dense() const { return DenseDistance{ dense_.data(), numCities_ }; }
+    PackedDistance packed() const { return PackedDistance{ packed_.data(), rowBase_.data() }; }
+
+    int numCities() const { return numCities_; }
+    DistanceLayout layout() const { return layout_; }
+    const TspInstance& instance() const { return instance_; }
+    double buildSeconds() const { return buildSeconds_; }
+
+    size_t memoryBytes() const {
+        return dense_.capacity() * sizeof(double) + packed_.capacity() * sizeof(float)
+            + rowBase_.capacity() * sizeof(int64_t);
+    }
+
+private:
+    const TspInstance& instance_;
+    int numCities_;
+    DistanceLayout layout_;
+    double buildSeconds_ = 0.0;
+
+    // Not zero-filled on resize: the threads building the rows place their pages (see Affinity.h)
+    std::vector<double, UninitializedAllocator<double>> dense_;
+    std::vector<float, UninitializedAllocator<float>> packed_;
+    std::vector<int64_t> rowBase_;
+};
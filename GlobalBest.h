@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include "Population.h"
+
+// Best tour found by any worker, shared without a mutex.
+//
+// The distance is an atomic lowered by compare-and-swap, so a worker that
+// cannot improve it pays one relaxed load. Only a worker that wins the CAS
+// writes the route, into a snapshot guarded by an epoch counter (a seqlock):
+// the epoch is odd while the route is being written, and readers retry until
+// they see the same even epoch before and after copying.
+
+template <typename Index>
+class GlobalBest {
+public:
+    explicit GlobalBest(int numCities) : route_(numCities) {}
+
+    GlobalBest(const GlobalBest&) = delete;
+    GlobalBest& operator=(const GlobalBest&) = delete;
+
+    double distance() const { return distance_.load(std::memory_order_relaxed); }
+
+    // Publishes `route` if it is shorter than the current best; returns whether it was.
+    bool offer(const Index* route, double length) {
+        double current = distance_.load(std::memory_order_relaxed);
+        do {
+            if (!(length < current)) {
+                return false;
+            }
+        } while (!distance_.compare_exchange_weak(current, length, std::memory_order_relaxed));
+
+        // Another winner may be writing a shorter route; take the epoch and
+        // write only if the snapshot still holds something longer.
+        unsigned epoch = epoch_.load(std::memory_order_relaxed);
+        while ((epoch & 1u) != 0 || !epoch_.compare_exchange_weak(epoch, epoch + 1, std::memory_order_acquire)) {
+            std::this_thread::yield();
+            epoch = epoch_.load(std::memory_order_relaxed);
+        }
+        if (length < snapshotDistance_) {
+            std::copy(route, route + route_.size(), route_.begin());
+            snapshotDistance_ = length;
+        }
+        epoch_.store(epoch + 2, std::memory_order_release);
+        return true;
+    }
+
+    // Copies a consistent (route, length) pair; returns the epoch it was read at.
+    unsigned snapshot(std::vector<Index>& route, double& length) const {
+        while (true) {
+            const unsigned before = epoch_.load(std::memory_order_acquire);
+            if ((before & 1u) == 0) {
+                route.assign(route_.begin(), route_.end());
+                length = snapshotDistance_;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (epoch_.load(std::memory_order_relaxed) == before) {
+                    return before;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    unsigned epoch() const { return epoch_.load(std::memory_order_acquire); }
+
+private:
+    alignas(kCacheLineBytes) std::atomic<double> distance_{ std::numeric_limits<double>::max() };
+    alignas(kCacheLineBytes) std::atomic<unsigned> epoch_{ 0 };
+    std::vector<Index> route_;
+    double snapshotDistance_ = std::numeric_limits<double>::max();
+};
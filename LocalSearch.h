@@ -0,0 +1,267 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "NeighborLists.h"
+#include "Tour.h"
+#include "Random.h"
+
+// Memetic local search: 2-opt and Or-opt moves restricted to the k nearest
+// neighbours of each city, driven by a queue of cities whose don't-look bit
+// is clear. A city's bit is set once no improving move starts at it and is
+// cleared again when a move changes one of its edges.
+//
+// Every move is applied as one to three segment reversals, each reversing
+// whichever side of the cycle is shorter. Below kTwoLevelMinCities the tour
+// stays a plain array (ArrayTour); above it, where a reversal of up to n/2
+// cities dominates, the route is loaded into a two-level list (TwoLevelTour)
+// for the call and written back at the end, with the same result (Tour.h).
+// Keep one LocalSearch per thread (or per MPI rank); it owns all of its scratch.
+
+enum class LocalSearchMode {
+    None,    // pure GA
+    All,     // improve every child
+    Elite,   // improve the best rate * populationSize slots (slot 0 is the carried-over elite)
+    Random   // improve each child with probability rate
+};
+
+inline const char* localSearchName(LocalSearchMode mode) {
+    switch (mode) {
+    case LocalSearchMode::None:   return "none";
+    case LocalSearchMode::All:    return "all";
+    case LocalSearchMode::Elite:  return "elite";
+    case LocalSearchMode::Random: return "random";
+    }
+    return "unknown";
+}
+
+inline bool parseLocalSearchMode(const std::string& name, LocalSearchMode& mode) {
+    for (LocalSearchMode candidate : { LocalSearchMode::None, LocalSearchMode::All, LocalSearchMode::Elite, LocalSearchMode::Random }) {
+        if (name == localSearchName(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether slot `slot` of the generation being built gets the local search.
+inline bool shouldImprove(LocalSearchMode mode, double rate, int slot, int populationSize, Rng& rng) {
+    switch (mode) {
+    case LocalSearchMode::None:   return false;
+    case LocalSearchMode::All:    return true;
+    case LocalSearchMode::Elite:  return slot < std::max(1, static_cast<int>(rate * populationSize));
+    case LocalSearchMode::Random: return rng.chance(rate);
+    }
+    return false;
+}
+
+class LocalSearch {
+public:
+    static constexpr int kMaxSegment = 3;  // Or-opt moves segments of 1..3 cities
+    static constexpr int kTwoLevelMinCities = 8192;
+
+    // Improves `route` until no 2-opt or Or-opt move helps; every city starts
+    // active. Returns the change in tour length (<= 0).
+    template <typename Index, typename Distance>
+    double improve(Index* route, int numCities, const NeighborLists& neighbors, const Distance& distance) {
+        reset(numCities);
+        for (int city = 0; city < numCities; ++city) {
+            activate(city);
+        }
+        return run(route, numCities, neighbors, distance);
+    }
+
+    // Same, but after crossover and mutation: only cities with an edge found
+    // in neither parent start active, so a child that is mostly made of
+    // locally optimal parent edges costs little more than a scan.
+    template <typename Index, typename Distance>
+    double improve(Index* route, int numCities, const NeighborLists& neighbors, const Distance& distance,
+                   const Index* parent1, const Index* parent2) {
+        reset(numCities);
+        parentPosition1_.resize(numCities);
+        parentPosition2_.resize(numCities);
+        for (int i = 0; i < numCities; ++i) {
+            parentPosition1_[parent1[i]] = i;
+            parentPosition2_[parent2[i]] = i;
+        }
+        auto inParent = [&](const Index* parent, const std::vector<int>& position, int a, int b) {
+            const int p = position[a];
+            return static_cast<int>(parent[p + 1 == numCities ? 0 : p + 1]) == b
+                || static_cast<int>(parent[p == 0 ? numCities - 1 : p - 1]) == b;
+        };
+        for (int i = 0; i < numCities; ++i) {
+            const int a = route[i];
+            const int b = route[i + 1 == numCities ? 0 : i + 1];
+            if (!inParent(parent1, parentPosition1_, a, b) && !inParent(parent2, parentPosition2_, a, b)) {
+                activate(a);
+                activate(b);
+            }
+        }
+        return run(route, numCities, neighbors, distance);
+    }
+
+private:
+    void reset(int numCities) {
+        numCities_ = numCities;
+        active_.assign(numCities, 0);
+        queue_.clear();
+        queueHead_ = 0;
+    }
+
+    void activate(int city) {
+        if (!active_[city]) {
+            active_[city] = 1;
+            queue_.push_back(city);
+        }
+    }
+
+    // Replaces tour edges (a, b) and (c, d) by (a, c) and (b, d), where b
+    // follows a and d follows c in the same direction.
+    template <typename Tour>
+    static void move2opt(Tour& tour, int a, int b, int c, int d) {
+        if (tour.next(a) == b) {
+            tour.reverse(b, c);
+        } else {
+            tour.reverse(a, d);
+        }
+    }
+
+    template <typename Index, typename Distance>
+    double run(Index* route, int numCities, const NeighborLists& neighbors, const Distance& distance) {
+        if (numCities >= kTwoLevelMinCities) {
+            twoLevel_.assign(route, numCities);
+            const double total = search(twoLevel_, neighbors, distance);
+            twoLevel_.copyTo(route);
+            return total;
+        }
+        ArrayTour<Index> tour(route, numCities, position_);
+        return search(tour, neighbors, distance);
+    }
+
+    template <typename Tour, typename Distance>
+    double search(Tour& tour, const NeighborLists& neighbors, const Distance& distance) {
+        double total = 0.0;
+        while (queueHead_ < queue_.size()) {
+            const int city = queue_[queueHead_++];
+            active_[city] = 0;
+            double delta = twoOpt(tour, city, neighbors, distance);
+            if (delta == 0.0) {
+                delta = orOpt(tour, city, neighbors, distance);
+            }
+            if (delta != 0.0) {
+                total += delta;
+                activate(city);
+            }
+            // Reclaim the consumed front of the queue now and then
+            if (queueHead_ > 4096 && 2 * queueHead_ > queue_.size()) {
+                queue_.erase(queue_.begin(), queue_.begin() + queueHead_);
+                queueHead_ = 0;
+            }
+        }
+        return total;
+    }
+
+    // First improving 2-opt move that adds an edge from `a` to one of its neighbours.
+    template <typename Tour, typename Distance>
+    double twoOpt(Tour& tour, int a, const NeighborLists& neighbors, const Distance& distance) {
+        const int* candidates = neighbors.of(a);
+        for (int direction = 0; direction < 2; ++direction) {
+            const int b = direction == 0 ? tour.next(a) : tour.prev(a);
+            const double removed = distance(a, b);
+            for (int n = 0; n < neighbors.k(); ++n) {
+                const int c = candidates[n];
+                const double added = distance(a, c);
+                if (added >= removed) {
+                    break;
+                }
+                const int d = direction == 0 ? tour.next(c) : tour.prev(c);
+                if (c == b || d == a) {
+                    continue;
+                }
+                const double delta = added + distance(b, d) - removed - distance(c, d);
+                if (delta < -kEpsilon) {
+                    move2opt(tour, a, b, c, d);
+                    activate(b);
+                    activate(c);
+                    activate(d);
+                    return delta;
+                }
+            }
+        }
+        return 0.0;
+    }
+
+    // First improving move of the segment of 1..kMaxSegment cities starting at
+    // `first` to another edge next to a neighbour of one of its ends.
+    template <typename Tour, typename Distance>
+    double orOpt(Tour& tour, int first, const NeighborLists& neighbors, const Distance& distance) {
+        int last = first;
+        for (int length = 1; length <= kMaxSegment && length + 2 < numCities_; ++length) {
+            if (length > 1) {
+                last = tour.next(last);
+            }
+            const int p = tour.prev(first);
+            const int nx = tour.next(last);
+            const double removeGain = distance(p, first) + distance(last, nx) - distance(p, nx);
+            if (removeGain <= kEpsilon) {
+                continue;
+            }
+            auto inSegment = [&](int city) { return tour.between(first, city, last); };
+
+            // Each end of the segment looks at its neighbours c and at both tour
+            // edges of c; (x, y) is the edge, y following x.
+            for (int end = 0; end < 2; ++end) {
+                const int near = end == 0 ? first : last;
+                const int* candidates = neighbors.of(near);
+                for (int n = 0; n < neighbors.k(); ++n) {
+                    const int c = candidates[n];
+                    const double link = distance(near, c);
+                    if (link >= removeGain) {
+                        break;
+                    }
+                    if (inSegment(c)) {
+                        continue;
+                    }
+                    for (int side = 0; side < 2; ++side) {
+                        const int x = side == 0 ? c : tour.prev(c);
+                        const int y = side == 0 ? tour.next(c) : c;
+                        if (inSegment(x) || inSegment(y) || x == nx || y == p) {
+                            continue;
+                        }
+                        // `forward` keeps the segment's direction: x, first .. last, y
+                        const bool forward = (end == 0) == (side == 0);
+                        const double added = forward ? distance(x, first) + distance(last, y)
+                                                     : distance(x, last) + distance(first, y);
+                        const double delta = added - distance(x, y) - removeGain;
+                        if (delta < -kEpsilon) {
+                            move2opt(tour, p, first, x, y);    // (p, x), (first, y)
+                            move2opt(tour, p, x, nx, last);    // (p, nx), (x, last)
+                            if (forward) {
+                                move2opt(tour, x, last, first, y);  // (x, first), (last, y)
+                            }
+                            activate(p);
+                            activate(nx);
+                            activate(x);
+                            activate(y);
+                            activate(last);
+                            return delta;
+                        }
+                    }
+                }
+            }
+        }
+        return 0.0;
+    }
+
+    static constexpr double kEpsilon = 1e-7;
+
+    int numCities_ = 0;
+    std::vector<int> position_;
+    TwoLevelTour twoLevel_;
+    std::vector<int> parentPosition1_, parentPosition2_;
+    std::vector<unsigned char> active_;
+    std::vector<int> queue_;
+    size_t queueHead_ = 0;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include "City.h"
+
+// Edge-weight functions as metric policies: small copyable functors with an
+// inline operator()(a, b), so a GA instantiated on one of them computes each
+// edge without a branch on the weight type. TspInstance::distance() goes
+// through the same functions, so the two can never disagree.
+
+struct Euc2DMetric {
+    const City* cities;
+
+    static const char* name() { return "EUC_2D"; }
+    double operator()(int a, int b) const {
+        return static_cast<int>(calculateDistance(cities[a], cities[b]) + 0.5);
+    }
+};
+
+struct Ceil2DMetric {
+    const City* cities;
+
+    static const char* name() { return "CEIL_2D"; }
+    double operator()(int a, int b) const {
+        return std::ceil(calculateDistance(cities[a], cities[b]));
+    }
+};
+
+// Pseudo-euclidean distance of the att instances.
+struct AttMetric {
+    const City* cities;
+
+    static const char* name() { return "ATT"; }
+    double operator()(int a, int b) const {
+        double dx = cities[a].x - cities[b].x;
+        double dy = cities[a].y - cities[b].y;
+        double r = std::sqrt((dx * dx + dy * dy) / 10.0);
+        int t = static_cast<int>(r + 0.5);
+        return t < r ? t + 1 : t;
+    }
+};
+
+// Great-circle distance on the TSPLIB idealised sphere; coordinates in radians.
+struct GeoMetric {
+    const double* latitude;
+    const double* longitude;
+
+    static const char* name() { return "GEO"; }
+    double operator()(int a, int b) const {
+        if (a == b) {
+            return 0.0;
+        }
+        const double RRR = 6378.388;
+        double q1 = std::cos(longitude[a] - longitude[b]);
+        double q2 = std::cos(latitude[a] - latitude[b]);
+        double q3 = std::cos(latitude[a] + latitude[b]);
+        return static_cast<int>(RRR * std::acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+    }
+};
+
+// Full symmetric matrix given in the file, row-major.
+struct ExplicitMetric {
+    const double* weights;
+    int numCities;
+
+    static const char* name() { return "EXPLICIT"; }
+    double operator()(int a, int b) const {
+        return weights[static_cast<size_t>(a) * numCities + b];
+    }
+};
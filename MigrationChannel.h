@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include "Population.h"
+
+// Bounded single-producer/single-consumer channel carrying migrant tours from
+// one island to the next. Slots are allocated once; send() and receive() copy
+// a route in or out and never block or allocate; on a full or empty channel
+// they return false and the caller decides whether to wait.
+
+template <typename Index>
+class MigrationChannel {
+public:
+    MigrationChannel(int numCities, int capacity = 4)
+        : numCities_(numCities), capacity_(capacity + 1),
+          routes_(static_cast<size_t>(capacity_) * numCities), lengths_(capacity_) {}
+
+    MigrationChannel(const MigrationChannel&) = delete;
+    MigrationChannel& operator=(const MigrationChannel&) = delete;
+
+    // Producer side; returns false (and drops the tour) when the channel is full.
+    bool send(const Index* route, double length) {
+        const int tail = tail_.load(std::memory_order_relaxed);
+        const int next = (tail + 1) % capacity_;
+        if (next == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::copy(route, route + numCities_, slot(tail));
+        lengths_[tail] = length;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; returns false when no migrant is waiting.
+    bool receive(Index* route, double& length) {
+        const int head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const Index* source = slot(head);
+        std::copy(source, source + numCities_, route);
+        length = lengths_[head];
+        head_.store((head + 1) % capacity_, std::memory_order_release);
+        return true;
+    }
+
+private:
+    Index* slot(int i) { return routes_.data() + static_cast<size_t>(i) * numCities_; }
+
+    const int numCities_;
+    const int capacity_;  // one slot stays empty to tell full from empty
+    std::vector<Index> routes_;
+    std::vector<double> lengths_;
+    alignas(kCacheLineBytes) std::atomic<int> head_{ 0 };
+    alignas(kCacheLineBytes) std::atomic<int> tail_{ 0 };
+};
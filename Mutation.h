@@ -0,0 +1,198 @@
+#pragma once
+
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include "Random.h"
+
+// Mutation operators that return the exact change in tour length.
+//
+// Only the edges next to the modified positions are re-scored, so a swap or
+// insertion costs O(1) to evaluate and an inversion O(1) plus the reversal
+// itself. `distance` is any callable taking two city indices. A functor that
+// returns a class type instead of a number (HashedDistance in TourHash.h) has
+// its values summed the same way, so one pass can track more than the length.
+
+enum class MutationType {
+    Swap,       // exchange two cities
+    Insertion,  // move one city to another position
+    Inversion,  // reverse a segment (2-opt move)
+    Scramble    // shuffle a segment
+};
+
+inline const char* mutationName(MutationType type) {
+    switch (type) {
+    case MutationType::Swap:      return "swap";
+    case MutationType::Insertion: return "insertion";
+    case MutationType::Inversion: return "inversion";
+    case MutationType::Scramble:  return "scramble";
+    }
+    return "unknown";
+}
+
+inline bool parseMutationType(const std::string& name, MutationType& type) {
+    for (MutationType candidate : { MutationType::Swap, MutationType::Insertion, MutationType::Inversion, MutationType::Scramble }) {
+        if (name == mutationName(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// What the moves return: a double for a numeric functor, otherwise the functor's own value type.
+template <typename Index, typename Distance>
+using MoveDelta = std::conditional_t<std::is_arithmetic_v<decltype(std::declval<const Distance&>()(Index(), Index()))>,
+    double, decltype(std::declval<const Distance&>()(Index(), Index()))>;
+
+// Length of the edge leaving position k, i.e. (route[k], route[k + 1]).
+template <typename Index, typename Distance>
+inline MoveDelta<Index, Distance> edgeAfter(const Index* route, int numCities, int k, const Distance& distance) {
+    return distance(route[k], route[k + 1 == numCities ? 0 : k + 1]);
+}
+
+template <typename Index, typename Distance>
+MoveDelta<Index, Distance> swapMove(Index* route, int numCities, int i, int j, const Distance& distance) {
+    if (i == j || numCities < 4) {
+        std::swap(route[i], route[j]);
+        return {};
+    }
+
+    // The edges touching positions i and j, without duplicates when i and j are adjacent.
+    int edges[4] = { (i + numCities - 1) % numCities, i, (j + numCities - 1) % numCities, j };
+    int numEdges = 2;
+    for (int e = 2; e < 4; ++e) {
+        if (edges[e] != edges[0] && edges[e] != edges[1]) {
+            edges[numEdges++] = edges[e];
+        }
+    }
+
+    MoveDelta<Index, Distance> before{};
+    for (int e = 0; e < numEdges; ++e) {
+        before += edgeAfter(route, numCities, edges[e], distance);
+    }
+    std::swap(route[i], route[j]);
+    MoveDelta<Index, Distance> after{};
+    for (int e = 0; e < numEdges; ++e) {
+        after += edgeAfter(route, numCities, edges[e], distance);
+    }
+    return after - before;
+}
+
+// Removes the city at position i and reinserts it at position j.
+template <typename Index, typename Distance>
+MoveDelta<Index, Distance> insertionMove(Index* route, int numCities, int i, int j, const Distance& distance) {
+    if (i == j || numCities < 3) {
+        return {};
+    }
+
+    MoveDelta<Index, Distance> delta{};
+    const bool rotation = (i == 0 && j == numCities - 1) || (i == numCities - 1 && j == 0);
+    if (!rotation) {
+        Index moved = route[i];
+        Index prev = route[(i + numCities - 1) % numCities];
+        Index next = route[(i + 1) % numCities];
+        delta += distance(prev, next) - distance(prev, moved) - distance(moved, next);
+        // The city lands between route[j] and its neighbour on the far side of i.
+        Index a = i < j ? route[j] : route[(j + numCities - 1) % numCities];
+        Index b = i < j ? route[(j + 1) % numCities] : route[j];
+        delta += distance(a, moved) + distance(moved, b) - distance(a, b);
+    }
+
+    if (i < j) {
+        std::rotate(route + i, route + i + 1, route + j + 1);
+    } else {
+        std::rotate(route + j, route + i, route + i + 1);
+    }
+    return delta;
+}
+
+// Reverses route[i..j] (i <= j).
+template <typename Index, typename Distance>
+MoveDelta<Index, Distance> inversionMove(Index* route, int numCities, int i, int j, const Distance& distance) {
+    if (j - i < 1 || j - i >= numCities - 2) {
+        // Reversing the whole tour, or all but one city, leaves the cycle unchanged.
+        std::reverse(route + i, route + j + 1);
+        return {};
+    }
+    Index prev = route[(i + numCities - 1) % numCities];
+    Index next = route[(j + 1) % numCities];
+    MoveDelta<Index, Distance> delta = distance(prev, route[j]) + distance(route[i], next)
+        - distance(prev, route[i]) - distance(route[j], next);
+    std::reverse(route + i, route + j + 1);
+    return delta;
+}
+
+// Shuffles route[i..j] (i <= j); costs O(j - i).
+template <typename Index, typename Distance>
+MoveDelta<Index, Distance> scrambleMove(Index* route, int numCities, int i, int j, const Distance& distance, Rng& rng) {
+    if (j - i < 1) {
+        return {};
+    }
+    const bool wholeTour = j - i + 1 >= numCities - 1;
+    const int firstEdge = wholeTour ? 0 : (i + numCities - 1) % numCities;
+    const int numEdges = wholeTour ? numCities : j - i + 2;
+
+    MoveDelta<Index, Distance> before{};
+    for (int e = 0; e < numEdges; ++e) {
+        before += edgeAfter(route, numCities, (firstEdge + e) % numCities, distance);
+    }
+    for (int k = j; k > i; --k) {
+        std::swap(route[k], route[i + rng.below(k - i + 1)]);
+    }
+    MoveDelta<Index, Distance> after{};
+    for (int e = 0; e < numEdges; ++e) {
+        after += edgeAfter(route, numCities, (firstEdge + e) % numCities, distance);
+    }
+    return after - before;
+}
+
+// Mutation rates from here up draw a chance per position; below it the gaps
+// between mutated positions are drawn instead.
+constexpr double kDenseMutationRate = 0.5;
+
+// Applies the operator at every position with probability mutationRate and
+// returns the resulting change in tour length. At the usual low rates the gap
+// to the next mutated position is drawn from the geometric distribution, so a
+// child costs one draw per mutation plus one, not one per city.
+template <typename Index, typename Distance>
+MoveDelta<Index, Distance> mutate(MutationType type, Index* route, int numCities, double mutationRate, const Distance& distance, Rng& rng) {
+    MoveDelta<Index, Distance> delta{};
+    auto mutateAt = [&](int i) {
+        int j = rng.below(numCities);
+        switch (type) {
+        case MutationType::Swap:
+            delta += swapMove(route, numCities, i, j, distance);
+            break;
+        case MutationType::Insertion:
+            delta += insertionMove(route, numCities, i, j, distance);
+            break;
+        case MutationType::Inversion:
+            delta += inversionMove(route, numCities, std::min(i, j), std::max(i, j), distance);
+            break;
+        case MutationType::Scramble:
+            delta += scrambleMove(route, numCities, std::min(i, j), std::max(i, j), distance, rng);
+            break;
+        }
+    };
+    if (mutationRate >= kDenseMutationRate) {
+        for (int i = 0; i < numCities; ++i) {
+            if (rng.chance(mutationRate)) {
+                mutateAt(i);
+            }
+        }
+        return delta;
+    }
+    if (!(mutationRate > 0.0)) {
+        return delta;
+    }
+    // P(gap = g) = (1 - rate)^g * rate; counted in double, as a gap can exceed any int
+    const double logKeep = std::log1p(-mutationRate);
+    for (double i = std::floor(std::log(1.0 - rng.uniform()) / logKeep); i < numCities;
+         i += 1.0 + std::floor(std::log(1.0 - rng.uniform()) / logKeep)) {
+        mutateAt(static_cast<int>(i));
+    }
+    return delta;
+}
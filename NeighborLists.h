@@ -0,0 +1,254 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+#include "TspInstance.h"
+
+// Uniform grid over the city coordinates, sized for about two cities per cell.
+class SpatialGrid {
+public:
+    explicit SpatialGrid(const std::vector<City>& cities) : cities_(cities) {
+        const int n = static_cast<int>(cities.size());
+        minX_ = minY_ = 0.0;
+        double maxX = 0.0, maxY = 0.0;
+        if (n > 0) {
+            minX_ = maxX = cities[0].x;
+            minY_ = maxY = cities[0].y;
+        }
+        for (const City& city : cities) {
+            minX_ = std::min(minX_, city.x);
+            maxX = std::max(maxX, city.x);
+            minY_ = std::min(minY_, city.y);
+            maxY = std::max(maxY, city.y);
+        }
+
+        // A collinear or thin set gets a side of at least extent / n, so the grid stays
+        // about n / 2 cells instead of one long row of tiny cells
+        double extent = std::max(maxX - minX_, maxY - minY_);
+        if (!(extent > 0.0)) {
+            extent = 1.0;
+        }
+        double width = std::max(maxX - minX_, extent / std::max(n, 1));
+        double height = std::max(maxY - minY_, extent / std::max(n, 1));
+        cellSize_ = std::sqrt(width * height * 2.0 / std::max(n, 1));
+        // Clamped in double before the int cast; a clamped side gets wider cells, which
+        // are kept square so that ring r stays at least (r - 1) * cellSize_ away
+        const double maxCells = 1 << 15;
+        cols_ = static_cast<int>(std::min(std::floor(width / cellSize_) + 1.0, maxCells));
+        rows_ = static_cast<int>(std::min(std::floor(height / cellSize_) + 1.0, maxCells));
+        cellSize_ = std::max(cellSize_, std::max(width / cols_, height / rows_));
+
+        // Counting sort of the cities into cells.
+        cellStart_.assign(static_cast<size_t>(cols_) * rows_ + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            ++cellStart_[cellOf(cities[i]) + 1];
+        }
+        for (size_t c = 1; c < cellStart_.size(); ++c) {
+            cellStart_[c] += cellStart_[c - 1];
+        }
+        members_.resize(n);
+        std::vector<int> fill(cellStart_.begin(), cellStart_.end() - 1);
+        for (int i = 0; i < n; ++i) {
+            members_[fill[cellOf(cities[i])]++] = i;
+        }
+    }
+
+    int cols() const { return cols_; }
+    int rows() const { return rows_; }
+    double cellSize() const { return cellSize_; }
+
+    int column(double x) const { return std::min(std::max(static_cast<int>((x - minX_) / cellSize_), 0), cols_ - 1); }
+    int row(double y) const { return std::min(std::max(static_cast<int>((y - minY_) / cellSize_), 0), rows_ - 1); }
+
+    // Calls visit(city) for every city in cell (col, row).
+    template <typename Visit>
+    void forEachInCell(int col, int row, Visit visit) const {
+        size_t cell = static_cast<size_t>(row) * cols_ + col;
+        for (int k = cellStart_[cell]; k < cellStart_[cell + 1]; ++k) {
+            visit(members_[k]);
+        }
+    }
+
+    // The last ring around (col, row) that still has cells inside the grid.
+    int maxRing(int col, int row) const {
+        return std::max(std::max(col, cols_ - 1 - col), std::max(row, rows_ - 1 - row));
+    }
+
+    // Calls visit(city) for every city in the square ring of cells at Chebyshev
+    // distance `ring` around (col, row). Only the cells inside the grid are
+    // stepped over, so a ring costs O(ring) even on a grid of one row.
+    template <typename Visit>
+    void forEachInRing(int col, int row, int ring, Visit visit) const {
+        const int firstRow = std::max(row - ring, 0), lastRow = std::min(row + ring, rows_ - 1);
+        const int firstCol = std::max(col - ring, 0), lastCol = std::min(col + ring, cols_ - 1);
+        for (int r = firstRow; r <= lastRow; ++r) {
+            if (ring == 0 || r == row - ring || r == row + ring) {
+                for (int c = firstCol; c <= lastCol; ++c) {
+                    forEachInCell(c, r, visit);
+                }
+                continue;
+            }
+            if (col - ring >= 0) {
+                forEachInCell(col - ring, r, visit);
+            }
+            if (col + ring < cols_) {
+                forEachInCell(col + ring, r, visit);
+            }
+        }
+    }
+
+    // Returns the nearest city accepted by `keep`, or -1 when none is left.
+    // Cells are scanned ring by ring until the ring is farther than the best hit.
+    template <typename Keep>
+    int nearest(double x, double y, Keep keep) const {
+        const int col = column(x), row = this->row(y);
+        const int lastRing = maxRing(col, row);
+        int best = -1;
+        double bestDistance = 0.0;
+        for (int ring = 0; ring <= lastRing; ++ring) {
+            if (best != -1 && (ring - 1) * cellSize_ > bestDistance) {
+                break;
+            }
+            forEachInRing(col, row, ring, [&](int city) {
+                if (!keep(city)) {
+                    return;
+                }
+                double dx = cities_[city].x - x, dy = cities_[city].y - y;
+                double d = std::sqrt(dx * dx + dy * dy);
+                if (best == -1 || d < bestDistance) {
+                    best = city;
+                    bestDistance = d;
+                }
+            });
+        }
+        return best;
+    }
+
+private:
+    size_t cellOf(const City& city) const {
+        return static_cast<size_t>(row(city.y)) * cols_ + column(city.x);
+    }
+
+    const std::vector<City>& cities_;
+    double minX_, minY_, cellSize_;
+    int cols_, rows_;
+    std::vector<int> cellStart_;
+    std::vector<int> members_;
+};
+
+// The k nearest cities of every city, nearest first, in one flat array.
+// Planar metrics (EUC_2D, CEIL_2D, ATT) are ordered like the plain euclidean
+// distance and are built from a SpatialGrid in roughly O(n k log k); GEO and
+// EXPLICIT instances fall back to an O(n^2) scan of the metric.
+class NeighborLists {
+public:
+    static constexpr int kDefaultNeighbors = 8;
+
+    explicit NeighborLists(const TspInstance& instance, int k = kDefaultNeighbors) {
+        auto start = std::chrono::steady_clock::now();
+        const int n = instance.numCities();
+        k_ = std::max(0, std::min(k, n - 1));
+        neighbors_.resize(static_cast<size_t>(n) * k_);
+
+        const bool planar = instance.hasCoordinates() && (instance.weightType == EdgeWeightType::Euc2D
+            || instance.weightType == EdgeWeightType::Ceil2D || instance.weightType == EdgeWeightType::Att);
+        if (k_ > 0 && planar) {
+            buildFromGrid(instance.cities);
+        } else if (k_ > 0) {
+            buildByScan(instance);
+        }
+
+        buildSeconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    int k() const { return k_; }
+    const int* of(int city) const { return &neighbors_[static_cast<size_t>(city) * k_]; }
+    double buildSeconds() const { return buildSeconds_; }
+    size_t memoryBytes() const { return neighbors_.capacity() * sizeof(int); }
+
+private:
+    void buildFromGrid(const std::vector<City>& cities) {
+        const int n = static_cast<int>(cities.size());
+        SpatialGrid grid(cities);
+
+#ifdef _OPENMP
+        #pragma omp parallel
+#endif
+        {
+            std::vector<std::pair<double, int>> heap;  // max-heap of the best k so far
+            heap.reserve(k_ + 1);
+
+#ifdef _OPENMP
+            #pragma omp for schedule(dynamic, 64)
+#endif
+            for (int a = 0; a < n; ++a) {
+                heap.clear();
+                const int col = grid.column(cities[a].x), row = grid.row(cities[a].y);
+                const int lastRing = grid.maxRing(col, row);
+                for (int ring = 0; ring <= lastRing; ++ring) {
+                    // Every city in this ring is at least (ring - 1) cells away.
+                    if (static_cast<int>(heap.size()) == k_) {
+                        double reach = (ring - 1) * grid.cellSize();
+                        if (reach > 0.0 && reach * reach > heap.front().first) {
+                            break;
+                        }
+                    }
+                    grid.forEachInRing(col, row, ring, [&](int b) {
+                        if (b == a) {
+                            return;
+                        }
+                        double dx = cities[a].x - cities[b].x, dy = cities[a].y - cities[b].y;
+                        double d2 = dx * dx + dy * dy;
+                        if (static_cast<int>(heap.size()) < k_) {
+                            heap.emplace_back(d2, b);
+                            std::push_heap(heap.begin(), heap.end());
+                        } else if (d2 < heap.front().first) {
+                            std::pop_heap(heap.begin(), heap.end());
+                            heap.back() = std::make_pair(d2, b);
+                            std::push_heap(heap.begin(), heap.end());
+                        }
+                    });
+                }
+                std::sort_heap(heap.begin(), heap.end());
+                int* out = &neighbors_[static_cast<size_t>(a) * k_];
+                for (int j = 0; j < k_; ++j) {
+                    out[j] = heap[j].second;
+                }
+            }
+        }
+    }
+
+    void buildByScan(const TspInstance& instance) {
+        const int n = instance.numCities();
+#ifdef _OPENMP
+        #pragma omp parallel
+#endif
+        {
+            std::vector<std::pair<double, int>> candidates(n > 0 ? n - 1 : 0);
+
+#ifdef _OPENMP
+            #pragma omp for schedule(dynamic, 16)
+#endif
+            for (int a = 0; a < n; ++a) {
+                int m = 0;
+                for (int b = 0; b < n; ++b) {
+                    if (b != a) {
+                        candidates[m++] = std::make_pair(instance.distance(a, b), b);
+                    }
+                }
+                std::partial_sort(candidates.begin(), candidates.begin() + k_, candidates.end());
+                int* out = &neighbors_[static_cast<size_t>(a) * k_];
+                for (int j = 0; j < k_; ++j) {
+                    out[j] = candidates[j].second;
+                }
+            }
+        }
+    }
+
+    int k_;
+    std::vector<int> neighbors_;
+    double buildSeconds_ = 0.0;
+};
@@ -1,93 +1,384 @@
 #include <iostream>
-#include <fstream>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <ctime>
+#include <chrono>
 #include <limits>
+#include <mutex>
+#include <type_traits>
 #include <omp.h>  // <-- Include OpenMP
+#include "Options.h"
+#include "TspLoader.h"
+#include "Random.h"
+#include "Crossover.h"
+#include "Mutation.h"
+#include "DistanceCache.h"
+#include "NeighborLists.h"
+#include "Population.h"
+#include "TourKernel.h"
+#include "LocalSearch.h"
+#include "Selection.h"
+#include "Seeding.h"
+#include "TargetTimer.h"
+#include "Dispatch.h"
+#include "RunReport.h"
+#include "Telemetry.h"
+#include "Termination.h"
+#include "Checkpoint.h"
+#include "TourHash.h"
+#include "Affinity.h"
+#include "GlobalBest.h"
+#include "SteadyState.h"
+#include "WorkStealing.h"
 
 using namespace std;
 
-struct City {
-    int id;
-    double x, y;
-};
-
-double calculateDistance(const City& city1, const City& city2) {
-    double dx = city1.x - city2.x;
-    double dy = city1.y - city2.y;
-    return sqrt(dx * dx + dy * dy);
-}
-
-double calculateTotalDistance(const vector<int>& route, const vector<City>& cities) {
-    double totalDistance = 0.0;
-    int numCities = route.size();
-
-    for (int i = 0; i < numCities - 1; ++i) {
-        totalDistance += calculateDistance(cities[route[i]], cities[route[i + 1]]);
+// Parallel Population Initialization; lengths are cached from here on and only updated incrementally.
+template <typename Index, typename Distance>
+void seedPopulation(const Options& options, const TspInstance& instance, const DistanceCache& distances,
+    const NeighborLists& neighbors, const TourKernel& tourKernel, const Distance& distance, Population<Index>& population,
+    vector<LocalSearch>& localSearch, const TargetTimer& targetTimer) {
+    Seeder seeder(instance, neighbors, distances);
+    seeder.seed(population, options.seeding, options.seed, 0);
+    tourKernel.evaluate(population, distance);
+    double seedingSeconds = targetTimer.elapsedSeconds();
+
+    // A memetic run starts from local optima
+    if (options.localSearch != LocalSearchMode::None) {
+        #pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < population.size(); ++i) {
+            population.length(i) += localSearch[omp_get_thread_num()].improve(population[i], instance.numCities(), neighbors, distance);
+        }
     }
-
-    totalDistance += calculateDistance(cities[route[numCities - 1]], cities[route[0]]);
-
-    return totalDistance;
+    printSeedingReport(cout, options.seeding, population, seedingSeconds);
 }
 
-vector<int> generateRandomRoute(int numCities) {
-    vector<int> route(numCities);
-    for (int i = 0; i < numCities; ++i) {
-        route[i] = i;
+// The GA itself, compiled once per tour index type and distance functor (see Dispatch.h).
+template <typename Index, typename Distance>
+StopResult evolve(const Options& options, int numThreads, const TspInstance& instance, const DistanceCache& distances,
+    const NeighborLists& neighbors, const TourKernel& tourKernel, const Distance& distance,
+    vector<int>& bestRoute, double& bestDistance, TargetTimer& targetTimer, Termination& termination, vector<Telemetry>& telemetry,
+    Checkpointer& checkpointer, const CheckpointFile* resume, TourHashStats& hashStats) {
+    const int numCities = instance.numCities();
+    int populationSize = options.populationSize;
+    double mutationRate = options.mutationRate;
+    double crossoverRate = options.crossoverRate;
+    CrossoverType crossoverType = options.crossoverType;
+    MutationType mutationType = options.mutationType;
+
+    // All tours live in one contiguous arena holding this and the next generation
+    Population<Index> population(populationSize, numCities);
+
+    // One crossover and local-search scratch per thread so the offspring loop shares no state
+    vector<CrossoverScratch> crossoverScratch(numThreads);
+    vector<LocalSearch> localSearch(numThreads);
+
+    // Every individual draws from its own stream, so the run does not depend on
+    // the thread count or schedule, and a checkpoint needs no random state
+    CheckpointState checkpoint;
+    int firstGeneration = 0;
+    long long evaluations = 0;
+    targetTimer.restart();
+    if (resume != nullptr) {
+        // Continue a checkpointed run exactly where it left off
+        resume->restore(population, checkpoint);
+        firstGeneration = checkpoint.generation;
+        evaluations = checkpoint.evaluations;
+        bestRoute = checkpoint.bestRoute;
+        bestDistance = checkpoint.bestLength;
+        targetTimer.update(bestDistance);
+        termination.restoreProgress(checkpoint.progressBest, checkpoint.lastImprovement);
+        printResumeReport(cout, checkpointer.path(), firstGeneration);
+    } else {
+        seedPopulation(options, instance, distances, neighbors, tourKernel, distance, population, localSearch, targetTimer);
     }
-    random_shuffle(route.begin(), route.end());
-    return route;
-}
-
-vector<int> crossover(const vector<int>& parent1, const vector<int>& parent2) {
-    int numCities = parent1.size();
-    vector<int> child(numCities, -1);
 
-    int startPos = rand() % numCities;
-    int endPos = rand() % numCities;
-
-    if (startPos > endPos) {
-        swap(startPos, endPos);
+    // Tour hashes follow the population; each thread memoizes the tours it breeds
+    TourHashes hashes = options.tourHash.enabled() ? TourHashes(populationSize) : TourHashes();
+    vector<FitnessCache> fitnessCache(numThreads, FitnessCache(options.tourHash.cacheEntries));
+    if (hashes.enabled()) {
+        hashes.compute(population);
     }
 
-    for (int i = startPos; i <= endPos; ++i) {
-        child[i] = parent1[i];
+    Selector selector(options.selection, populationSize, options.numElites, options.tournamentSize);
+    vector<int> statsScratch;
+
+    // The state a generation starts from, handed to the checkpoint writer (see Checkpoint.h)
+    auto saveCheckpoint = [&](int generation) {
+        checkpoint.generation = generation;
+        checkpoint.evaluations = evaluations;
+        checkpoint.bestRoute = bestRoute;
+        checkpoint.bestLength = bestDistance;
+        checkpoint.progressBest = termination.progressBest();
+        checkpoint.lastImprovement = termination.lastImprovement();
+        checkpointer.save(population, checkpoint);
+    };
+
+    // Main Genetic Algorithm loop, until a stop condition holds (see Termination.h).
+    // Thread 0 runs the serial part, which includes the stop check, so its
+    // selection time is every other thread's wait at the start of the region
+    for (Telemetry& threadTelemetry : telemetry) {
+        threadTelemetry.start(firstGeneration);
     }
+    for (int generation = firstGeneration;; ++generation) {
+        // Selection reads the cached lengths in place and orders only the elite cut
+        telemetry[0].resume();
+        Rng selectionRng(options.seed, generation + 1, populationSize);
+        selector.prepare(population.lengths(), selectionRng);
+        const int best = selector.best();
+        if (population.length(best) < bestDistance) {
+            bestRoute.assign(population[best], population[best] + numCities);
+            bestDistance = population.length(best);
+            targetTimer.update(bestDistance);
+        }
+        const bool traced = telemetry[0].due(generation);
+        const bool measured = termination.measuresDiversity(generation);
+        const GenerationStats stats = traced || measured ? generationStats(population, best, statsScratch) : GenerationStats();
+        const StopReason reason = termination.check(generation, bestDistance, evaluations,
+            measured && termination.diversityCollapsed(stats.diversity));
+        if (reason != StopReason::None) {
+            if (telemetry[0].enabled()) {
+                const GenerationStats last = traced || measured ? stats : generationStats(population, best, statsScratch);
+                for (Telemetry& threadTelemetry : telemetry) {
+                    threadTelemetry.record(generation, last);
+                }
+            }
+            saveCheckpoint(generation);
+            for (const FitnessCache& cache : fitnessCache) {
+                hashStats.add(cache);
+            }
+            hashStats.duplicates = hashes.duplicates();
+            return { reason, generation };
+        }
+        if (checkpointer.due(generation, firstGeneration)) {
+            saveCheckpoint(generation);
+        }
+        telemetry[0].lap(Phase::Selection);
+
+        // Parallel Offspring Creation: each slot (elite copy or child) is written straight into its own row of the next generation
+        #pragma omp parallel
+        {
+            const int thread = omp_get_thread_num();
+            Telemetry& threadTelemetry = telemetry[thread];
+            threadTelemetry.resume();
+            long long bred = 0;
+
+            #pragma omp for schedule(dynamic) nowait
+            for (int i = 0; i < populationSize; ++i) {
+                Rng rng(options.seed, generation + 1, i);
+                if (i < selector.numElites()) {
+                    population.carryOver(selector.ranked()[i], i);
+                    if (hashes.enabled()) {
+                        hashes.carryOver(selector.ranked()[i], i);
+                    }
+                    threadTelemetry.lap(Phase::Selection);
+                    if (shouldImprove(options.localSearch, options.localSearchRate, i, populationSize, rng)) {
+                        population.nextLength(i) += localSearch[thread].improve(population.next(i), numCities, neighbors, distance);
+                        if (hashes.enabled()) {
+                            hashes.next(i) = tourHash(population.next(i), numCities);
+                        }
+                        threadTelemetry.lap(Phase::LocalSearch);
+                    }
+                    continue;
+                }
+                int parent1, parent2;
+                selector.parents(i, rng, parent1, parent2);
+                threadTelemetry.lap(Phase::Selection);
+                if (rng.chance(crossoverRate)) {
+                    crossover(crossoverType, population[parent1], population[parent2],
+                        population.next(i), numCities, crossoverScratch[thread], rng);
+                    threadTelemetry.lap(Phase::Crossover);
+                    population.nextLength(i) = hashes.enabled()
+                        ? scoreTour(tourKernel, population.next(i), numCities, distance, fitnessCache[thread], hashes.next(i))
+                        : tourKernel.tourLength(population.next(i), numCities, distance);
+                    threadTelemetry.lap(Phase::Evaluation);
+                } else {
+                    population.carryOver(parent1, i);
+                    if (hashes.enabled()) {
+                        hashes.carryOver(parent1, i);
+                    }
+                }
+                population.nextLength(i) += hashes.enabled()
+                    ? mutate(mutationType, population.next(i), numCities, mutationRate, distance, rng, hashes.next(i))
+                    : mutate(mutationType, population.next(i), numCities, mutationRate, distance, rng);
+                threadTelemetry.lap(Phase::Mutation);
+                if (shouldImprove(options.localSearch, options.localSearchRate, i, populationSize, rng)) {
+                    population.nextLength(i) += localSearch[thread].improve(population.next(i), numCities,
+                        neighbors, distance, population[parent1], population[parent2]);
+                    if (hashes.enabled()) {
+                        hashes.next(i) = tourHash(population.next(i), numCities);
+                    }
+                    threadTelemetry.lap(Phase::LocalSearch);
+                }
+                if (fitnessCache[thread].enabled()) {
+                    fitnessCache[thread].store(hashes.next(i), population.nextLength(i));
+                }
+                ++bred;
+            }
+            threadTelemetry.countEvaluations(bred);
+
+            // Time spent waiting for the slowest thread shows the load imbalance
+            if (threadTelemetry.enabled()) {
+                #pragma omp barrier
+                threadTelemetry.lap(Phase::Wait);
+                if (traced) {
+                    threadTelemetry.record(generation, stats);
+                }
+            }
+        }
 
-    int currentIndex = 0;
-    for (int i = 0; i < numCities; ++i) {
-        if (child[i] == -1) {
-            while (find(child.begin(), child.end(), parent2[currentIndex]) != child.end()) {
-                currentIndex = (currentIndex + 1) % numCities;
+        evaluations += populationSize - selector.numElites();
+        population.swapGenerations();
+        if (hashes.enabled()) {
+            hashes.swapGenerations();
+            if (options.tourHash.dedup) {
+                Rng dedupRng(options.seed, generation + 1, populationSize + 1);
+                hashes.replaceDuplicates(population, distance, dedupRng);
             }
-            child[i] = parent2[currentIndex];
-            currentIndex = (currentIndex + 1) % numCities;
         }
     }
-
-    return child;
 }
 
-void mutate(vector<int>& route, double mutationRate) {
-    int numCities = route.size();
-    for (int i = 0; i < numCities; ++i) {
-        if (rand() / static_cast<double>(RAND_MAX) < mutationRate) {
-            int j = rand() % numCities;
-            swap(route[i], route[j]);
+// The steady-state engine (see SteadyState.h). A generation here is the
+// populationSize - elites children the generational engine breeds per
+// generation, so --generations, --stagnation and the other stop conditions
+// mean the same evaluation budget in both engines. `placement` holds the CPU
+// of every worker under --bind (see bindThreads()), or nothing. Sets
+// `utilization` to the share of the workers' wall time spent breeding.
+template <typename Index, typename Distance>
+StopResult evolveSteady(const Options& options, int numThreads, const TspInstance& instance, const DistanceCache& distances,
+    const NeighborLists& neighbors, const TourKernel& tourKernel, const Distance& distance,
+    vector<int>& bestRoute, double& bestDistance, TargetTimer& targetTimer, Termination& termination,
+    const vector<int>& placement, double& utilization) {
+    const int numCities = instance.numCities();
+    const int populationSize = options.populationSize;
+    Population<Index> population(populationSize, numCities);
+    vector<CrossoverScratch> crossoverScratch(numThreads);
+    vector<LocalSearch> localSearch(numThreads);
+    targetTimer.restart();
+    seedPopulation(options, instance, distances, neighbors, tourKernel, distance, population, localSearch, targetTimer);
+
+    SteadyPopulation<Index> shared(population);
+    GlobalBest<Index> best(numCities);
+    for (int i = 0; i < populationSize; ++i) {
+        best.offer(population[i], population.length(i));
+    }
+    targetTimer.update(best.distance());
+
+    // Each worker breeds from copies of its parents, so it holds no lock while it works
+    struct Scratch {
+        vector<Index> parent1, parent2, child;
+    };
+    vector<Scratch> scratch(numThreads, { vector<Index>(numCities), vector<Index>(numCities), vector<Index>(numCities) });
+    vector<double> busySeconds(numThreads, 0.0);
+    const LocalSearchMode improveMode = options.localSearch == LocalSearchMode::Elite ? LocalSearchMode::Random : options.localSearch;
+    const int perGeneration = max(1, populationSize - options.numElites);
+    SharedStop stop(numThreads);
+    mutex monitor;
+    int checkedGeneration = 0;  // guarded by monitor
+
+    // One task breeds up to kSteadyChunk children; the first to finish a generation's worth checks the stop conditions
+    auto breed = [&](int worker, long long task, int count) {
+        if (stop.reason() != StopReason::None) {
+            return;
+        }
+        const auto taskStart = chrono::steady_clock::now();
+        Scratch& own = scratch[worker];
+        Rng rng(options.seed, static_cast<uint64_t>(task) + 1, populationSize + 2);
+        for (int c = 0; c < count; ++c) {
+            const double length1 = shared.copyOut(shared.tournament(rng, options.tournamentSize, false), own.parent1.data());
+            shared.copyOut(shared.tournament(rng, options.tournamentSize, false), own.parent2.data());
+            double length;
+            if (rng.chance(options.crossoverRate)) {
+                crossover(options.crossoverType, own.parent1.data(), own.parent2.data(), own.child.data(), numCities,
+                    crossoverScratch[worker], rng);
+                length = tourKernel.tourLength(own.child.data(), numCities, distance);
+            } else {
+                copy(own.parent1.begin(), own.parent1.end(), own.child.begin());
+                length = length1;
+            }
+            length += mutate(options.mutationType, own.child.data(), numCities, options.mutationRate, distance, rng);
+            if (shouldImprove(improveMode, options.localSearchRate, 0, populationSize, rng)) {
+                length += localSearch[worker].improve(own.child.data(), numCities, neighbors, distance,
+                    own.parent1.data(), own.parent2.data());
+            }
+            if (shared.replace(shared.tournament(rng, options.tournamentSize, true), own.child.data(), length)) {
+                best.offer(own.child.data(), length);
+            }
+        }
+        busySeconds[worker] += chrono::duration<double>(chrono::steady_clock::now() - taskStart).count();
+
+        const long long evaluations = stop.addEvaluations(count);
+        const int generation = static_cast<int>(evaluations / perGeneration);
+        unique_lock<mutex> lock(monitor, try_to_lock);
+        if (lock.owns_lock() && generation > checkedGeneration) {
+            checkedGeneration = generation;
+            targetTimer.update(best.distance());
+            const StopReason reason = termination.check(generation, best.distance(), evaluations, false);
+            if (reason != StopReason::None) {
+                stop.request(reason);
+            }
         }
+    };
+
+    // One stream of tasks until the budget of --generations is bred or a stop
+    // condition holds. The pool's threads are started from the main thread and
+    // inherit its CPU, so with --bind each worker pins itself to its own
+    WorkStealingPool pool(numThreads);
+    const long long budget = static_cast<long long>(options.numGenerations) * perGeneration;
+    const auto engineStart = chrono::steady_clock::now();
+    pool.runWhile([&](int worker) {
+        if (!placement.empty()) {
+            detail::pinCurrentThread(placement[worker]);
+        }
+    }, [&](int worker, long long task) {
+        const long long first = task * kSteadyChunk;
+        if (stop.reason() != StopReason::None || (budget > 0 && first >= budget)) {
+            return false;
+        }
+        breed(worker, task, static_cast<int>(budget > 0 ? min<long long>(kSteadyChunk, budget - first) : kSteadyChunk));
+        return true;
+    });
+    const double engineSeconds = chrono::duration<double>(chrono::steady_clock::now() - engineStart).count();
+    double totalBusy = 0.0;
+    for (double seconds : busySeconds) {
+        totalBusy += seconds;
     }
+    utilization = engineSeconds > 0.0 ? totalBusy / (engineSeconds * numThreads) : 0.0;
+
+    shared.finish();
+    vector<Index> route;
+    best.snapshot(route, bestDistance);
+    bestRoute.assign(route.begin(), route.end());
+    targetTimer.update(bestDistance);
+    const int generations = static_cast<int>(stop.addEvaluations(0) / perGeneration);
+    return { stop.reason() != StopReason::None ? stop.reason() : StopReason::Generations, generations };
 }
 
-int main() {
-    srand(42);
+int main(int argc, char* argv[]) {
+    Options options;
+    string error;
+    if (!parseOptions(argc, argv, options, error)) {
+        cerr << error << endl;
+        printUsage(cerr, argv[0]);
+        return 1;
+    }
+    if (options.showHelp) {
+        printUsage(cout, argv[0]);
+        return 0;
+    }
 
-    const int NUM_THREADS = 8; // or any other desired number
+    const int NUM_THREADS = options.numThreads > 0 ? options.numThreads : 8;
+    if (options.engine == Engine::Steady) {
+        const char* unsupported = unsupportedBySteadyEngine(options);
+        if (unsupported != nullptr) {
+            cerr << unsupported << " needs --engine generational" << endl;
+            return 1;
+        }
+    }
     omp_set_num_threads(NUM_THREADS);
 
-
     const string LIGHT_BLUE = "\033[94m";
     const string GREEN = "\033[32m";
     const string YELLOW = "\033[33m";
@@ -97,82 +388,100 @@ int main() {
     cout << GREEN + "           TRAVELING SALESMAN PROBLEM     " + RESET << endl;
     cout << GREEN + "================================================" + RESET << endl << endl;
 
-    // Record the start time
-    double startTime = omp_get_wtime(); 
-
-    ifstream inputFile("burma14.tsp");
-    if (!inputFile) {
-        cerr << "Failed to open input file." << endl;
-        return 1;
+    // Pin the threads before the distance cache is built, so its rows stay where they were written
+    const vector<int> placement = bindThreads(options.bind, NUM_THREADS);
+    if (options.bind != BindMode::None) {
+        cout << "Threads: " << NUM_THREADS << ", "
+            << (placement.empty() ? string("binding unsupported") : "bound " + string(bindName(options.bind)) + " to CPUs " + cpuList(placement))
+            << endl;
     }
 
-    string line;
-    vector<City> cities;
-
-    while (inputFile >> line) {
-        if (line == "NODE_COORD_SECTION") {
-            break;
-        }
-    }
+    // Record the start time; the time limit counts from here
+    double startTime = omp_get_wtime();
+    Termination termination(options.stop, options.numGenerations, options.targetLength);
+    installInterruptHandler();
 
-    while (inputFile >> line) {
-        if (line == "EOF") {
-            break;
-        }
-        City city;
-        inputFile >> city.id >> city.x >> city.y;
-        cities.push_back(city);
+    TspInstance instance;
+    bool fromCache = false;
+    auto loadStart = chrono::steady_clock::now();
+    if (!loadTspInstance(options.instancePath, instance, error, options.useCache, true, &fromCache)) {
+        cerr << error << endl;
+        return 1;
     }
-
-    int numCities = cities.size();
-    int populationSize = 100;
-    int numGenerations = 100;
-    double mutationRate = 0.01;
+    double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - loadStart).count();
+
+    int numCities = instance.numCities();
+
+    // Precompute the distance cache, the candidate neighbour lists and the SoA tour kernel
+    DistanceCache distances(instance);
+    NeighborLists neighbors(instance);
+    TourKernel tourKernel(instance, distances);
+    cout << LIGHT_BLUE << "Instance: " << instance.name << " (" << numCities << " cities, "
+        << edgeWeightTypeName(instance.weightType) << "), loaded in " << loadSeconds * 1000.0 << " ms"
+        << (fromCache ? " from cache" : "") << endl;
+    cout << "Distance cache: " << distanceLayoutName(distances.layout()) << ", "
+        << distances.memoryBytes() / 1048576.0 << " MB, built in " << distances.buildSeconds() * 1000.0 << " ms" << endl;
+    cout << "Neighbor lists: k = " << neighbors.k() << ", " << neighbors.memoryBytes() / 1048576.0
+        << " MB, built in " << neighbors.buildSeconds() * 1000.0 << " ms" << endl;
+    cout << "Tour kernel: " << tourKernel.description() << RESET << endl << endl;
 
     vector<int> bestRoute;
     double bestDistance = numeric_limits<double>::max();
-
-    vector<vector<int>> population(populationSize);
-
-    // Parallel Population Initialization
-    #pragma omp parallel for
-    for (int i = 0; i < populationSize; ++i) {
-        population[i] = generateRandomRoute(numCities);
+    TargetTimer targetTimer(options.targetLength);
+    vector<Telemetry> telemetry(NUM_THREADS);
+    StopResult stop;
+    TourHashStats hashStats;
+    double utilization = 0.0;
+    for (int thread = 0; thread < NUM_THREADS; ++thread) {
+        if (!telemetry[thread].open(options.tracePath, options.traceFormat, options.traceInterval, "openmp", thread, NUM_THREADS, error)) {
+            cerr << error << endl;
+            return 1;
+        }
     }
 
-    // Main Genetic Algorithm loop
-    for (int generation = 0; generation < numGenerations; ++generation) {
-        vector<pair<int, double>> fitness(populationSize);  // Allocate space to prevent reallocation
+    // One population, so one checkpoint file whatever the thread count
+    CheckpointWriter checkpointWriter;
+    Checkpointer checkpointer(options.checkpoint, checkpointWriter, { instance.name, numCities, options.seed, 0, 1, options.populationSize });
+    const bool resume = options.checkpoint.resume && checkpointExists(checkpointer.path());
+    if (options.checkpoint.resume && !resume) {
+        cout << "No checkpoint at " << checkpointer.path() << ", starting a new run" << endl;
+    }
 
-        // Parallel Fitness Evaluation
-    #pragma omp parallel for
-        for (int i = 0; i < populationSize; ++i) {
-            double distance = calculateTotalDistance(population[i], cities);
-            fitness[i] = make_pair(i, 1.0 / distance);
+    double gaStart = omp_get_wtime();
+    int status = dispatchSpecialization(instance, distances, [&](auto index, const auto& distance) {
+        using Index = decltype(index);
+        cout << LIGHT_BLUE << "Specialization: " << specializationName<Index, decay_t<decltype(distance)>>() << RESET << endl;
+        CheckpointFile checkpoint;
+        if (resume && !checkpoint.open<Index>(checkpointer.path(), checkpointer.id(), error)) {
+            cerr << error << endl;
+            return 1;
         }
-
-        sort(fitness.begin(), fitness.end(), [](const pair<int, double>& a, const pair<int, double>& b) {
-            return a.second > b.second;
-            });
-
-        vector<vector<int>> newPopulation(populationSize);
-
-        newPopulation[0] = population[fitness[0].first];
-        if (1.0 / fitness[0].second < bestDistance) {
-            bestRoute = population[fitness[0].first];
-            bestDistance = 1.0 / fitness[0].second;
+        if (options.engine == Engine::Steady) {
+            stop = evolveSteady<Index>(options, NUM_THREADS, instance, distances, neighbors, tourKernel, distance, bestRoute,
+                bestDistance, targetTimer, termination, placement, utilization);
+            return 0;
         }
-
-        // Parallel Offspring Creation
-        #pragma omp parallel for schedule(dynamic)
-        for (int i = 1; i < populationSize; ++i) {
-            int parent1 = fitness[i - 1].first;
-            int parent2 = fitness[i].first;
-            newPopulation[i] = crossover(population[parent1], population[parent2]);
-            mutate(newPopulation[i], mutationRate);
+        stop = evolve<Index>(options, NUM_THREADS, instance, distances, neighbors, tourKernel, distance, bestRoute, bestDistance,
+            targetTimer, termination, telemetry, checkpointer, resume ? &checkpoint : nullptr, hashStats);
+        return 0;
+    });
+    double gaSeconds = omp_get_wtime() - gaStart;
+    if (status != 0) {
+        return 1;
+    }
+    if (!checkpointWriter.finish(error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    for (Telemetry& threadTelemetry : telemetry) {
+        if (!threadTelemetry.close(error)) {
+            cerr << error << endl;
+            return 1;
         }
-
-        population = newPopulation;
+    }
+    if (!options.tracePath.empty() && !mergeTraceParts(options.tracePath, options.traceFormat, NUM_THREADS, error)) {
+        cerr << error << endl;
+        return 1;
     }
 
     cout << YELLOW + "\nResults:" + RESET << endl;
@@ -182,10 +491,25 @@ int main() {
     }
     cout << RESET << "\n\n";
     cout << GREEN << "Total distance: " << bestDistance << RESET << endl;
+    printTimeToTarget(cout, targetTimer);
+    printStopReason(cout, stop.reason, stop.generations, gaSeconds);
+    printTourHashReport(cout, options.tourHash, hashStats);
+    if (options.engine == Engine::Steady) {
+        cout << "Steady-state engine: " << NUM_THREADS << " workers busy " << utilization * 100.0 << "% of the time" << endl;
+    }
 
     double endTime = omp_get_wtime();  // <-- Changed to OpenMP timer
     double duration = endTime - startTime;
-    cout << YELLOW + "Time taken by function: " << static_cast<int>(duration) << " seconds" + RESET << endl;
+    cout << YELLOW + "Time taken by function: " << duration << " seconds" + RESET << endl;
+
+    if (!options.reportPath.empty()) {
+        RunReport report{ options.engine == Engine::Steady ? "openmp-steady" : "openmp", instance.name, numCities, NUM_THREADS, options.populationSize, stop.generations,
+            options.seed, duration, gaSeconds, bestDistance, targetTimer.seconds(), stopReasonName(stop.reason) };
+        if (!appendRunReport(options.reportPath, report, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+    }
 
 
     cout << GREEN + "\nThank you for using the Genetic Algorithm TSP Solver!" + RESET << endl;
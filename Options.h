@@ -0,0 +1,318 @@
+#pragma once
+
+#include <string>
+#include <algorithm>
+#include <iterator>
+#include <cstdlib>
+#include <cstdint>
+#include <ostream>
+#include "Crossover.h"
+#include "Mutation.h"
+#include "Topology.h"
+#include "LocalSearch.h"
+#include "Selection.h"
+#include "Seeding.h"
+#include "Telemetry.h"
+#include "Termination.h"
+#include "Checkpoint.h"
+#include "TourHash.h"
+#include "Affinity.h"
+#include "SteadyState.h"
+
+// Command-line options shared by all programs.
+//
+//   program [options] [instance.tsp]
+//
+// Anything a program does not use (e.g. --threads for Serial) is accepted
+// and ignored, so one command line works for every backend.
+
+struct Options {
+    std::string instancePath = "burma14.tsp";
+    int populationSize = 100;
+    int numGenerations = 100;            // 0: no limit (needs another stop condition)
+    double mutationRate = 0.01;
+    double crossoverRate = 0.9;
+    SelectionType selection = SelectionType::Tournament;
+    int tournamentSize = 3;
+    int numElites = 1;                   // best tours copied unchanged into the next generation
+    CrossoverType crossoverType = CrossoverType::OX;
+    MutationType mutationType = MutationType::Swap;
+    int numThreads = 0;  // 0: the program's default
+    BindMode bind = BindMode::None;      // OpenMP thread pinning (see Affinity.h)
+    Engine engine = Engine::Generational;  // OpenMP and MPI: generations or steady-state (see SteadyState.h)
+    uint64_t seed = 42;
+    Topology topology = Topology::Ring;  // island programs (threaded: ring only)
+    int migrationInterval = 10;          // generations between migrations
+    int numMigrants = 2;                 // tours sent per migration; 0 disables it
+    LocalSearchMode localSearch = LocalSearchMode::None;
+    double localSearchRate = 0.1;        // elite fraction or per-child probability
+    SeedingType seeding = SeedingType::Random;
+    double targetLength = 0.0;           // report time to reach this tour length; 0 disables it
+    StopConditions stop;                 // anytime mode: deadline, stagnation, ... (see Termination.h)
+    std::string reportPath;              // append a JSON line describing the run; empty: none
+    std::string tracePath;               // per-generation telemetry trace; empty: none
+    TraceFormat traceFormat = TraceFormat::Csv;
+    int traceInterval = 1;               // generations between trace rows
+    CheckpointOptions checkpoint;        // periodic checkpoints and resume (see Checkpoint.h)
+    TourHashOptions tourHash;            // duplicate detection and fitness cache (see TourHash.h)
+    bool useCache = true;
+    bool showHelp = false;
+};
+
+inline void printUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [options] [instance.tsp]\n"
+        << "  --instance PATH        TSPLIB instance (default burma14.tsp)\n"
+        << "  --population N         population size (default 100)\n"
+        << "  --generations N        maximum number of generations, 0 for no limit (default 100)\n"
+        << "  --mutation-rate R      per-city mutation probability (default 0.01)\n"
+        << "  --crossover-rate R     probability that a child is bred by crossover (default 0.9)\n"
+        << "  --selection NAME       tournament | rank | sus | truncation (default tournament)\n"
+        << "  --tournament-size N    tours per tournament (default 3)\n"
+        << "  --elites N             best tours kept unchanged each generation (default 1)\n"
+        << "  --crossover NAME       ox | pmx | cx | erx (default ox)\n"
+        << "  --mutation NAME        swap | insertion | inversion | scramble (default swap)\n"
+        << "  --threads N            worker threads for the OpenMP and threaded programs, per rank for hybrid MPI\n"
+        << "  --bind NAME            pin OpenMP threads: none | close | spread (default none)\n"
+        << "  --engine NAME          OpenMP and MPI: generational | steady (default generational)\n"
+        << "  --seeding NAME         initial tours: random | nn | greedy | hilbert | mst | mix (default random)\n"
+        << "  --target LENGTH        report the time until the best tour reaches LENGTH (default off)\n"
+        << "  --time-limit S         stop S seconds after the program started (default off)\n"
+        << "  --stop-at-target       stop once the best tour reaches the --target length\n"
+        << "  --stagnation N         stop after N generations without a shorter tour (default off)\n"
+        << "  --min-diversity D      stop once the edge diversity falls below D (default off)\n"
+        << "  --max-evaluations N    stop after N tours have been bred in total (default off)\n"
+        << "  --stop-check N         generations between diversity checks and MPI stop votes (default 5)\n"
+        << "  --local-search MODE    2-opt/Or-opt on children: none | all | elite | random (default none)\n"
+        << "  --local-search-rate R  elite fraction or per-child probability (default 0.1)\n"
+        << "  --topology NAME        migration topology for MPI: ring | torus | random (default ring)\n"
+        << "  --migration-interval N generations between migrations (default 10)\n"
+        << "  --migrants N           best tours sent per migration, 0 to disable (default 2)\n"
+        << "  --seed N               master random seed; equal seeds give equal runs (default 42)\n"
+        << "  --report PATH          append a one-line JSON summary of the run to PATH\n"
+        << "  --trace PATH           write per-worker phase times and convergence to PATH (default off)\n"
+        << "  --trace-format NAME    csv | json (JSON lines) (default csv)\n"
+        << "  --trace-interval N     generations between trace rows (default 1)\n"
+        << "  --checkpoint PATH      write the GA state to PATH (PATH.N per island or rank) (default off)\n"
+        << "  --checkpoint-interval N generations between checkpoints (default 100)\n"
+        << "  --resume               continue from the --checkpoint file(s) if present\n"
+        << "  --dedup                perturb tours that repeat another tour of their generation\n"
+        << "  --fitness-cache N      remember the lengths of N tours by hash, 0 to disable (default 0)\n"
+        << "  --no-cache             ignore and do not write the binary instance cache\n"
+        << "  --help                 show this message\n";
+}
+
+namespace detail {
+
+inline bool parseIntOption(const std::string& text, int minimum, int& value) {
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || parsed < minimum || parsed > 1000000000L) {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+inline bool parseSeedOption(const std::string& text, uint64_t& value) {
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+    if (text.empty() || text[0] == '-' || *end != '\0') {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+inline bool parseCountOption(const std::string& text, long long& value) {
+    char* end = nullptr;
+    long long parsed = std::strtoll(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || parsed < 1) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+inline bool parseLengthOption(const std::string& text, double& value) {
+    char* end = nullptr;
+    double parsed = std::strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || !(parsed >= 0.0 && parsed < 1e300)) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+inline bool parseRateOption(const std::string& text, double& value) {
+    char* end = nullptr;
+    double parsed = std::strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || !(parsed >= 0.0 && parsed <= 1.0)) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+}  // namespace detail
+
+// Whether `arg` is an option of parseOptions() that takes a value, for drivers
+// that pass the GA options through to it.
+inline bool isValueOption(const std::string& arg) {
+    static const char* const valueOptions[] = { "--instance", "--population", "--generations", "--mutation-rate",
+                                                "--crossover-rate", "--crossover", "--mutation", "--threads", "--seed",
+                                                "--topology", "--migration-interval", "--migrants", "--local-search",
+                                                "--local-search-rate", "--selection", "--tournament-size", "--elites",
+                                                "--seeding", "--target", "--report", "--trace", "--trace-format",
+                                                "--trace-interval", "--time-limit", "--stagnation", "--min-diversity",
+                                                "--max-evaluations", "--stop-check", "--checkpoint",
+                                                "--checkpoint-interval", "--fitness-cache", "--bind", "--engine" };
+    return std::find(std::begin(valueOptions), std::end(valueOptions), arg) != std::end(valueOptions);
+}
+
+inline bool parseOptions(int argc, char* argv[], Options& options, std::string& error) {
+    bool havePath = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            options.showHelp = true;
+            continue;
+        }
+        if (arg == "--no-cache") {
+            options.useCache = false;
+            continue;
+        }
+        if (arg == "--resume") {
+            options.checkpoint.resume = true;
+            continue;
+        }
+        if (arg == "--dedup") {
+            options.tourHash.dedup = true;
+            continue;
+        }
+        if (arg == "--stop-at-target") {
+            options.stop.stopAtTarget = true;
+            continue;
+        }
+        if (arg.compare(0, 2, "--") != 0) {
+            if (havePath) {
+                error = "Unexpected argument: " + arg;
+                return false;
+            }
+            options.instancePath = arg;
+            havePath = true;
+            continue;
+        }
+        if (!isValueOption(arg)) {
+            error = "Unknown option: " + arg;
+            return false;
+        }
+        if (i + 1 >= argc) {
+            error = "Missing value for " + arg;
+            return false;
+        }
+        const std::string value = argv[++i];
+        bool ok;
+        if (arg == "--instance") {
+            options.instancePath = value;
+            havePath = ok = true;
+        } else if (arg == "--population") {
+            ok = detail::parseIntOption(value, 2, options.populationSize);
+        } else if (arg == "--generations") {
+            ok = detail::parseIntOption(value, 0, options.numGenerations);
+        } else if (arg == "--mutation-rate") {
+            ok = detail::parseRateOption(value, options.mutationRate);
+        } else if (arg == "--crossover-rate") {
+            ok = detail::parseRateOption(value, options.crossoverRate);
+        } else if (arg == "--selection") {
+            ok = parseSelectionType(value, options.selection);
+        } else if (arg == "--tournament-size") {
+            ok = detail::parseIntOption(value, 1, options.tournamentSize);
+        } else if (arg == "--elites") {
+            ok = detail::parseIntOption(value, 0, options.numElites);
+        } else if (arg == "--crossover") {
+            ok = parseCrossoverType(value, options.crossoverType);
+        } else if (arg == "--mutation") {
+            ok = parseMutationType(value, options.mutationType);
+        } else if (arg == "--threads") {
+            ok = detail::parseIntOption(value, 1, options.numThreads);
+        } else if (arg == "--report") {
+            options.reportPath = value;
+            ok = !value.empty();
+        } else if (arg == "--trace") {
+            options.tracePath = value;
+            ok = !value.empty();
+        } else if (arg == "--trace-format") {
+            ok = parseTraceFormat(value, options.traceFormat);
+        } else if (arg == "--trace-interval") {
+            ok = detail::parseIntOption(value, 1, options.traceInterval);
+        } else if (arg == "--checkpoint") {
+            options.checkpoint.path = value;
+            ok = !value.empty();
+        } else if (arg == "--checkpoint-interval") {
+            ok = detail::parseIntOption(value, 1, options.checkpoint.interval);
+        } else if (arg == "--bind") {
+            ok = parseBindMode(value, options.bind);
+        } else if (arg == "--engine") {
+            ok = parseEngine(value, options.engine);
+        } else if (arg == "--fitness-cache") {
+            ok = detail::parseIntOption(value, 0, options.tourHash.cacheEntries);
+        } else if (arg == "--time-limit") {
+            ok = detail::parseLengthOption(value, options.stop.timeLimit);
+        } else if (arg == "--stagnation") {
+            ok = detail::parseIntOption(value, 1, options.stop.stagnation);
+        } else if (arg == "--min-diversity") {
+            ok = detail::parseRateOption(value, options.stop.minDiversity);
+        } else if (arg == "--max-evaluations") {
+            ok = detail::parseCountOption(value, options.stop.maxEvaluations);
+        } else if (arg == "--stop-check") {
+            ok = detail::parseIntOption(value, 1, options.stop.checkInterval);
+        } else if (arg == "--seeding") {
+            ok = parseSeedingType(value, options.seeding);
+        } else if (arg == "--target") {
+            ok = detail::parseLengthOption(value, options.targetLength);
+        } else if (arg == "--local-search") {
+            ok = parseLocalSearchMode(value, options.localSearch);
+        } else if (arg == "--local-search-rate") {
+            ok = detail::parseRateOption(value, options.localSearchRate);
+        } else if (arg == "--topology") {
+            ok = parseTopology(value, options.topology);
+        } else if (arg == "--migration-interval") {
+            ok = detail::parseIntOption(value, 1, options.migrationInterval);
+        } else if (arg == "--migrants") {
+            ok = detail::parseIntOption(value, 0, options.numMigrants);
+        } else {
+            ok = detail::parseSeedOption(value, options.seed);
+        }
+        if (!ok) {
+            error = "Invalid value for " + arg + ": " + value;
+            return false;
+        }
+    }
+    if (options.numElites >= options.populationSize) {
+        error = "--elites must be below --population";
+        return false;
+    }
+    if (options.stop.stopAtTarget && options.targetLength <= 0.0) {
+        error = "--stop-at-target needs --target";
+        return false;
+    }
+    if (options.checkpoint.resume && !options.checkpoint.enabled()) {
+        error = "--resume needs --checkpoint";
+        return false;
+    }
+    if (options.numGenerations == 0 && !options.stop.any()) {
+        error = "--generations 0 needs another stop condition, e.g. --time-limit";
+        return false;
+    }
+    return true;
+}
+
+// The first option given that the steady-state engine does not support, or nullptr.
+inline const char* unsupportedBySteadyEngine(const Options& options) {
+    return options.checkpoint.enabled() ? "--checkpoint"
+        : !options.tracePath.empty() ? "--trace"
+        : options.tourHash.enabled() ? "--dedup and --fitness-cache"
+        : options.stop.minDiversity > 0.0 ? "--min-diversity"
+        : options.selection != SelectionType::Tournament ? "--selection other than tournament"
+        : nullptr;
+}
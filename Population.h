@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+// Population store: every tour of a generation lives in one aligned,
+// contiguous buffer with a fixed row stride. Two generations are allocated up
+// front and swapped by pointer, so the GA loop never allocates or deep-copies.
+//
+//   population[i]          current tour i (read while breeding)
+//   population.next(i)     tour i of the generation being built
+//   population.length(i)   cached tour length of population[i]
+//   population.swapGenerations()
+//
+// Rows are padded to a 64-byte multiple. The current generation is the single
+// block data() .. data() + size() * stride(), which can be sent as one MPI message.
+
+constexpr size_t kCacheLineBytes = 64;
+
+inline void* alignedAllocate(size_t bytes, size_t alignment) {
+#ifdef _MSC_VER
+    void* memory = _aligned_malloc(bytes, alignment);
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignment, bytes) != 0) {
+        memory = nullptr;
+    }
+#endif
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+inline void alignedFree(void* memory) {
+#ifdef _MSC_VER
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+template <typename Index>
+class Population {
+public:
+    Population(int size, int numCities)
+        : size_(size), numCities_(numCities) {
+        const size_t perLine = kCacheLineBytes / sizeof(Index);
+        stride_ = (static_cast<size_t>(numCities) + perLine - 1) / perLine * perLine;
+        const size_t rows = static_cast<size_t>(size) * stride_;
+        buffer_ = static_cast<Index*>(alignedAllocate(std::max<size_t>(2 * rows, 1) * sizeof(Index), kCacheLineBytes));
+        current_ = buffer_;
+        next_ = buffer_ + rows;
+        lengths_.assign(size, 0.0);
+        nextLengths_.assign(size, 0.0);
+    }
+
+    ~Population() {
+        alignedFree(buffer_);
+    }
+
+    Population(const Population&) = delete;
+    Population& operator=(const Population&) = delete;
+
+    Population(Population&& other) noexcept
+        : size_(other.size_), numCities_(other.numCities_), stride_(other.stride_),
+          buffer_(other.buffer_), current_(other.current_), next_(other.next_),
+          lengths_(std::move(other.lengths_)), nextLengths_(std::move(other.nextLengths_)) {
+        other.buffer_ = other.current_ = other.next_ = nullptr;
+    }
+
+    int size() const { return size_; }
+    int numCities() const { return numCities_; }
+    size_t stride() const { return stride_; }
+
+    Index* operator[](int i) { return current_ + static_cast<size_t>(i) * stride_; }
+    const Index* operator[](int i) const { return current_ + static_cast<size_t>(i) * stride_; }
+    Index* next(int i) { return next_ + static_cast<size_t>(i) * stride_; }
+
+    double& length(int i) { return lengths_[i]; }
+    double length(int i) const { return lengths_[i]; }
+    double& nextLength(int i) { return nextLengths_[i]; }
+    double* lengths() { return lengths_.data(); }
+    const double* lengths() const { return lengths_.data(); }
+
+    // Copies current tour `from` (and its length) into slot `to` of the next generation.
+    void carryOver(int from, int to) {
+        std::copy((*this)[from], (*this)[from] + numCities_, next(to));
+        nextLengths_[to] = lengths_[from];
+    }
+
+    void swapGenerations() {
+        std::swap(current_, next_);
+        lengths_.swap(nextLengths_);
+    }
+
+    // The current generation as one contiguous block of size() * stride() indices.
+    Index* data() { return current_; }
+    const Index* data() const { return current_; }
+    size_t dataBytes() const { return static_cast<size_t>(size_) * stride_ * sizeof(Index); }
+
+private:
+    int size_;
+    int numCities_;
+    size_t stride_;
+    Index* buffer_;
+    Index* current_;
+    Index* next_;
+    std::vector<double> lengths_;
+    std::vector<double> nextLengths_;
+};
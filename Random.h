@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+// Fast per-worker random numbers (xoshiro256**).
+//
+// Every generator is derived from one master seed plus up to two stream
+// counters, e.g. Rng(seed, generation, individual), so a worker never shares
+// state with another and a run is reproducible no matter which thread or
+// process happens to draw from which stream. The sequences are defined here
+// rather than by the standard library, so results are also identical across
+// compilers.
+
+inline uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+class Rng {
+public:
+    using result_type = uint64_t;
+
+    explicit Rng(uint64_t seed = 42, uint64_t stream = 0, uint64_t substream = 0) {
+        uint64_t mix = seed;
+        mix = splitMix64(mix) ^ stream;
+        mix = splitMix64(mix) ^ substream;
+        for (uint64_t& word : state_) {
+            word = splitMix64(mix);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()() {
+        const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, bound) by multiply-shift; bound must be below 2^32.
+    int below(int bound) {
+        return static_cast<int>(((*this)() >> 32) * static_cast<uint32_t>(bound) >> 32);
+    }
+
+    // Uniform double in [0, 1).
+    double uniform() {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    bool chance(double probability) {
+        return uniform() < probability;
+    }
+
+    // The raw generator state, e.g. for a checkpoint; setState() continues the sequence exactly.
+    void state(uint64_t words[4]) const {
+        for (int w = 0; w < 4; ++w) {
+            words[w] = state_[w];
+        }
+    }
+
+    void setState(const uint64_t words[4]) {
+        for (int w = 0; w < 4; ++w) {
+            state_[w] = words[w];
+        }
+    }
+
+    // Fisher-Yates shuffle of values[0..count).
+    template <typename T>
+    void shuffle(T* values, int count) {
+        for (int i = count - 1; i > 0; --i) {
+            std::swap(values[i], values[below(i + 1)]);
+        }
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state_[4];
+};
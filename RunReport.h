@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdint>
+
+// One machine-readable line per run, appended to the file given with
+// --report (JSON Lines). scaling.py collects these to build its speedup
+// and efficiency tables; any other tool can read them line by line.
+
+struct RunReport {
+    std::string program;        // serial | openmp | openmp-steady | threading | mpi | hybrid | mpi-farm | hybrid-farm | decompose
+    std::string instance;
+    int numCities = 0;
+    int workers = 1;            // threads, ranks for MPI, ranks x threads for hybrid
+    int populationSize = 0;
+    int numGenerations = 0;     // generations actually run
+    uint64_t seed = 0;
+    double seconds = 0.0;       // wall time of the whole run, loading included
+    double gaSeconds = 0.0;     // wall time of seeding and the generations
+    double bestDistance = 0.0;
+    double timeToTarget = -1.0; // -1: no target or not reached
+    std::string stopReason;     // see stopReasonName() in Termination.h
+};
+
+inline std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += ' ';
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+inline bool appendRunReport(const std::string& path, const RunReport& report, std::string& error) {
+    std::ostringstream line;
+    line << std::setprecision(10)
+         << "{\"program\": \"" << jsonEscape(report.program) << "\""
+         << ", \"instance\": \"" << jsonEscape(report.instance) << "\""
+         << ", \"cities\": " << report.numCities
+         << ", \"workers\": " << report.workers
+         << ", \"population\": " << report.populationSize
+         << ", \"generations\": " << report.numGenerations
+         << ", \"seed\": " << report.seed
+         << ", \"seconds\": " << report.seconds
+         << ", \"ga_seconds\": " << report.gaSeconds
+         << ", \"best\": " << report.bestDistance
+         << ", \"time_to_target\": " << report.timeToTarget
+         << ", \"stop\": \"" << jsonEscape(report.stopReason) << "\"}\n";
+
+    std::ofstream out(path, std::ios::app);
+    if (!out || !(out << line.str()) || !out.flush()) {
+        error = "Cannot append the run report to " + path;
+        return false;
+    }
+    return true;
+}
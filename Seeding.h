@@ -0,0 +1,390 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include "TspInstance.h"
+#include "DistanceCache.h"
+#include "NeighborLists.h"
+#include "Population.h"
+#include "Random.h"
+
+// Constructive seeding of the initial population.
+//
+//   random    uniform shuffle
+//   nn        nearest neighbour from a random start; now and then takes the
+//             second-nearest candidate
+//   greedy    greedy matching over the k-nearest-neighbour edges (shortest
+//             first, no city above degree two, no early cycle), fragments then
+//             joined nearest-endpoint first
+//   hilbert   cities in the order of a randomly shifted Hilbert curve
+//   mst       "Christofides-lite": preorder walk of a minimum spanning forest
+//             over the k-nearest-neighbour edges (no matching step)
+//   mix       cycles through nn, greedy, hilbert and mst
+//
+// Greedy and mst perturb every candidate edge by up to kEdgeNoise so two
+// individuals rarely get the same tour. Candidates come from NeighborLists and
+// leftovers are found with a SpatialGrid, so every construction is
+// sub-quadratic on planar instances; GEO and EXPLICIT instances fall back to
+// linear scans where a grid would be needed.
+
+enum class SeedingType { Random, NearestNeighbor, Greedy, Hilbert, Mst, Mix };
+
+inline const char* seedingName(SeedingType type) {
+    switch (type) {
+    case SeedingType::Random:          return "random";
+    case SeedingType::NearestNeighbor: return "nn";
+    case SeedingType::Greedy:          return "greedy";
+    case SeedingType::Hilbert:         return "hilbert";
+    case SeedingType::Mst:             return "mst";
+    case SeedingType::Mix:             return "mix";
+    }
+    return "unknown";
+}
+
+inline bool parseSeedingType(const std::string& name, SeedingType& type) {
+    for (SeedingType candidate : { SeedingType::Random, SeedingType::NearestNeighbor, SeedingType::Greedy,
+                                   SeedingType::Hilbert, SeedingType::Mst, SeedingType::Mix }) {
+        if (name == seedingName(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Position of (x, y) on a Hilbert curve over a 2^order x 2^order grid.
+inline uint64_t hilbertIndex(uint32_t x, uint32_t y, int order) {
+    uint64_t index = 0;
+    for (uint32_t s = 1u << (order - 1); s > 0; s >>= 1) {
+        const uint32_t rx = (x & s) ? 1 : 0;
+        const uint32_t ry = (y & s) ? 1 : 0;
+        index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - (x & (s - 1)) + (x & ~(s - 1));
+                y = s - 1 - (y & (s - 1)) + (y & ~(s - 1));
+                x &= (s << 1) - 1;
+                y &= (s << 1) - 1;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+class Seeder {
+public:
+    static constexpr double kEdgeNoise = 0.1;        // greedy/mst: edge weights scaled by 1 + U[0, kEdgeNoise)
+    static constexpr double kSecondChoice = 0.1;     // nn: chance of taking the second-nearest candidate
+    static constexpr int kHilbertOrder = 16;
+
+    Seeder(const TspInstance& instance, const NeighborLists& neighbors, const DistanceCache& distances)
+        : instance_(instance), neighbors_(neighbors), distances_(distances), numCities_(instance.numCities()) {
+        const bool planar = instance.hasCoordinates() && (instance.weightType == EdgeWeightType::Euc2D
+            || instance.weightType == EdgeWeightType::Ceil2D || instance.weightType == EdgeWeightType::Att);
+        if (planar) {
+            grid_.reset(new SpatialGrid(instance.cities));
+        }
+        if (instance.hasCoordinates()) {
+            minX_ = maxX_ = instance.cities[0].x;
+            minY_ = maxY_ = instance.cities[0].y;
+            for (const City& city : instance.cities) {
+                minX_ = std::min(minX_, city.x);
+                maxX_ = std::max(maxX_, city.x);
+                minY_ = std::min(minY_, city.y);
+                maxY_ = std::max(maxY_, city.y);
+            }
+        }
+
+        // Every undirected k-nearest-neighbour edge once
+        for (int a = 0; a < numCities_; ++a) {
+            const int* list = neighbors.of(a);
+            for (int n = 0; n < neighbors.k(); ++n) {
+                const int b = list[n];
+                const int* back = neighbors.of(b);
+                if (a < b || std::find(back, back + neighbors.k(), a) == back + neighbors.k()) {
+                    candidates_.push_back(Edge{ distances(a, b), a, b });
+                }
+            }
+        }
+    }
+
+    // The construction used for individual `index` under `type` (mix cycles).
+    static SeedingType typeFor(SeedingType type, int index) {
+        static const SeedingType cycle[] = { SeedingType::NearestNeighbor, SeedingType::Greedy, SeedingType::Hilbert, SeedingType::Mst };
+        return type == SeedingType::Mix ? cycle[index % 4] : type;
+    }
+
+    // Writes one tour built by `type` into route. Thread-safe: all scratch is local.
+    template <typename Index>
+    void build(SeedingType type, Index* route, Rng& rng) const {
+        switch (type) {
+        case SeedingType::NearestNeighbor:
+            nearestNeighbor(route, rng);
+            return;
+        case SeedingType::Greedy:
+            greedy(route, rng);
+            return;
+        case SeedingType::Hilbert:
+            if (instance_.hasCoordinates()) {
+                hilbert(route, rng);
+            } else {
+                nearestNeighbor(route, rng);
+            }
+            return;
+        case SeedingType::Mst:
+            spanningForestWalk(route, rng);
+            return;
+        case SeedingType::Random:
+        case SeedingType::Mix:
+            break;
+        }
+        for (int i = 0; i < numCities_; ++i) {
+            route[i] = static_cast<Index>(i);
+        }
+        rng.shuffle(route, numCities_);
+    }
+
+    // Seeds every row of `population` in parallel; individual i draws from its
+    // own stream, so the result does not depend on the thread count.
+    template <typename Index>
+    void seed(Population<Index>& population, SeedingType type, uint64_t seed, uint64_t stream) const {
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < population.size(); ++i) {
+            Rng rng(seed, kSeedingStream + stream, i);
+            build(typeFor(type, i), population[i], rng);
+        }
+    }
+
+private:
+    static constexpr uint64_t kSeedingStream = 0x5EED000000000000ULL;
+
+    struct Edge {
+        double weight;
+        int a, b;
+    };
+
+    // Nearest city accepted by keep(): the neighbour list first, then the grid
+    // (or a scan when there is no grid).
+    template <typename Keep>
+    int nearestAccepted(int from, Keep keep) const {
+        const int* list = neighbors_.of(from);
+        for (int n = 0; n < neighbors_.k(); ++n) {
+            if (keep(list[n])) {
+                return list[n];
+            }
+        }
+        if (grid_) {
+            return grid_->nearest(instance_.cities[from].x, instance_.cities[from].y, keep);
+        }
+        int best = -1;
+        double bestDistance = 0.0;
+        for (int city = 0; city < numCities_; ++city) {
+            if (keep(city)) {
+                double d = distances_(from, city);
+                if (best == -1 || d < bestDistance) {
+                    best = city;
+                    bestDistance = d;
+                }
+            }
+        }
+        return best;
+    }
+
+    template <typename Index>
+    void nearestNeighbor(Index* route, Rng& rng) const {
+        std::vector<unsigned char> visited(numCities_, 0);
+        int current = rng.below(numCities_);
+        for (int i = 0; i < numCities_; ++i) {
+            route[i] = static_cast<Index>(current);
+            visited[current] = 1;
+            if (i + 1 == numCities_) {
+                break;
+            }
+            auto unvisited = [&](int city) { return !visited[city]; };
+            int next = nearestAccepted(current, unvisited);
+            if (rng.chance(kSecondChoice)) {
+                // Second-nearest among the listed candidates, if there is one
+                const int* list = neighbors_.of(current);
+                bool skipped = false;
+                for (int n = 0; n < neighbors_.k(); ++n) {
+                    if (!visited[list[n]]) {
+                        if (skipped) {
+                            next = list[n];
+                            break;
+                        }
+                        skipped = true;
+                    }
+                }
+            }
+            current = next;
+        }
+    }
+
+    std::vector<Edge> perturbedCandidates(Rng& rng) const {
+        std::vector<Edge> edges(candidates_);
+        for (Edge& edge : edges) {
+            edge.weight *= 1.0 + kEdgeNoise * rng.uniform();
+        }
+        std::sort(edges.begin(), edges.end(), [](const Edge& x, const Edge& y) { return x.weight < y.weight; });
+        return edges;
+    }
+
+    static int findRoot(std::vector<int>& parent, int city) {
+        while (parent[city] != city) {
+            parent[city] = parent[parent[city]];
+            city = parent[city];
+        }
+        return city;
+    }
+
+    template <typename Index>
+    void greedy(Index* route, Rng& rng) const {
+        const int n = numCities_;
+        std::vector<int> parent(n);
+        std::iota(parent.begin(), parent.end(), 0);
+        std::vector<int> link(2 * static_cast<size_t>(n), -1);  // the (up to) two tour neighbours of each city
+        std::vector<unsigned char> degree(n, 0);
+        for (const Edge& edge : perturbedCandidates(rng)) {
+            if (degree[edge.a] < 2 && degree[edge.b] < 2) {
+                int rootA = findRoot(parent, edge.a), rootB = findRoot(parent, edge.b);
+                if (rootA != rootB) {
+                    parent[rootA] = rootB;
+                    link[2 * edge.a + degree[edge.a]++] = edge.b;
+                    link[2 * edge.b + degree[edge.b]++] = edge.a;
+                }
+            }
+        }
+
+        // Walk the fragments, each time jumping from the current end to the
+        // nearest end of a fragment not yet used
+        std::vector<unsigned char> used(n, 0);
+        int start = -1;
+        for (int city = 0; city < n && start == -1; ++city) {
+            if (degree[city] < 2) {
+                start = city;
+            }
+        }
+        int position = 0;
+        while (start != -1) {
+            int previous = -1, current = start;
+            while (current != -1) {
+                route[position++] = static_cast<Index>(current);
+                used[current] = 1;
+                int next = link[2 * current] != previous ? link[2 * current] : link[2 * current + 1];
+                if (degree[current] == 1 && previous != -1) {
+                    next = -1;
+                }
+                previous = current;
+                current = next;
+            }
+            auto openEnd = [&](int city) { return !used[city] && degree[city] < 2; };
+            start = position < n ? nearestAccepted(previous, openEnd) : -1;
+        }
+    }
+
+    template <typename Index>
+    void hilbert(Index* route, Rng& rng) const {
+        const double extent = std::max(std::max(maxX_ - minX_, maxY_ - minY_), 1e-9);
+        const double span = static_cast<double>((1u << kHilbertOrder) - 1);
+        // A random shift of the curve (the grid wraps) changes where it cuts the instance
+        const double shiftX = rng.uniform() * extent, shiftY = rng.uniform() * extent;
+        std::vector<std::pair<uint64_t, int>> keys(numCities_);
+        for (int i = 0; i < numCities_; ++i) {
+            double x = instance_.cities[i].x - minX_ + shiftX;
+            double y = instance_.cities[i].y - minY_ + shiftY;
+            x = x >= extent ? x - extent : x;
+            y = y >= extent ? y - extent : y;
+            keys[i] = std::make_pair(hilbertIndex(static_cast<uint32_t>(x / extent * span),
+                                                  static_cast<uint32_t>(y / extent * span), kHilbertOrder), i);
+        }
+        std::sort(keys.begin(), keys.end());
+        for (int i = 0; i < numCities_; ++i) {
+            route[i] = static_cast<Index>(keys[i].second);
+        }
+    }
+
+    template <typename Index>
+    void spanningForestWalk(Index* route, Rng& rng) const {
+        const int n = numCities_;
+        std::vector<int> parent(n);
+        std::iota(parent.begin(), parent.end(), 0);
+        std::vector<std::pair<int, int>> treeEdges;
+        treeEdges.reserve(n);
+        for (const Edge& edge : perturbedCandidates(rng)) {
+            int rootA = findRoot(parent, edge.a), rootB = findRoot(parent, edge.b);
+            if (rootA != rootB) {
+                parent[rootA] = rootB;
+                treeEdges.emplace_back(edge.a, edge.b);
+                treeEdges.emplace_back(edge.b, edge.a);
+            }
+        }
+        // Adjacency in CSR form, shortest edges first
+        std::vector<int> start(n + 1, 0), adjacent(treeEdges.size());
+        for (const auto& edge : treeEdges) {
+            ++start[edge.first + 1];
+        }
+        for (int c = 0; c < n; ++c) {
+            start[c + 1] += start[c];
+        }
+        std::vector<int> fill(start.begin(), start.end() - 1);
+        for (const auto& edge : treeEdges) {
+            adjacent[fill[edge.first]++] = edge.second;
+        }
+
+        // Preorder walk of each tree; trees are entered in nearest-neighbour
+        // order from wherever the previous walk ended
+        std::vector<unsigned char> visited(n, 0);
+        std::vector<int> stack;
+        int position = 0;
+        int root = rng.below(n);
+        while (root != -1) {
+            stack.push_back(root);
+            visited[root] = 1;
+            int last = root;
+            while (!stack.empty()) {
+                const int city = stack.back();
+                stack.pop_back();
+                route[position++] = static_cast<Index>(city);
+                last = city;
+                for (int e = start[city + 1] - 1; e >= start[city]; --e) {
+                    if (!visited[adjacent[e]]) {
+                        visited[adjacent[e]] = 1;
+                        stack.push_back(adjacent[e]);
+                    }
+                }
+            }
+            auto unvisited = [&](int city) { return !visited[city]; };
+            root = position < n ? nearestAccepted(last, unvisited) : -1;
+        }
+    }
+
+    const TspInstance& instance_;
+    const NeighborLists& neighbors_;
+    const DistanceCache& distances_;
+    int numCities_;
+    std::unique_ptr<SpatialGrid> grid_;
+    double minX_ = 0.0, maxX_ = 0.0, minY_ = 0.0, maxY_ = 0.0;
+    std::vector<Edge> candidates_;  // undirected k-nearest-neighbour edges
+};
+
+// One line on the seeded population, e.g. "Seeding: mix, best 152034, mean 171220, 12.5 ms".
+inline void printSeedingReport(std::ostream& out, SeedingType type, double best, double mean, double seconds) {
+    out << "Seeding: " << seedingName(type) << ", best " << best << ", mean " << mean
+        << ", " << seconds * 1000.0 << " ms" << std::endl;
+}
+
+template <typename Index>
+void printSeedingReport(std::ostream& out, SeedingType type, const Population<Index>& population, double seconds) {
+    const double* lengths = population.lengths();
+    const double best = *std::min_element(lengths, lengths + population.size());
+    const double mean = std::accumulate(lengths, lengths + population.size(), 0.0) / population.size();
+    printSeedingReport(out, type, best, mean, seconds);
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include "Random.h"
+
+// Parent selection over the flat array of cached tour lengths (shorter is
+// fitter). Nothing is fully sorted: prepare() uses nth_element to order only
+// the elite cut, in O(P) expected time, plus whatever the selection type
+// needs. After prepare(), parents() is const and may be called from any
+// number of threads, each with its own Rng.
+//
+//   tournament   best of `tournamentSize` uniform picks
+//   rank         linear ranking with pressure 1.5, sampled as a binary
+//                tournament the fitter tour wins with probability 0.75,
+//                which has the same selection probabilities without a sort
+//   sus          stochastic universal sampling on fitness 1 / length
+//   truncation   uniform among the better half
+
+enum class SelectionType { Tournament, Rank, Sus, Truncation };
+
+inline const char* selectionName(SelectionType type) {
+    switch (type) {
+    case SelectionType::Tournament: return "tournament";
+    case SelectionType::Rank:       return "rank";
+    case SelectionType::Sus:        return "sus";
+    case SelectionType::Truncation: return "truncation";
+    }
+    return "unknown";
+}
+
+inline bool parseSelectionType(const std::string& name, SelectionType& type) {
+    for (SelectionType candidate : { SelectionType::Tournament, SelectionType::Rank, SelectionType::Sus, SelectionType::Truncation }) {
+        if (name == selectionName(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+class Selector {
+public:
+    static constexpr double kRankPressure = 1.5;
+    static constexpr double kTruncationFraction = 0.5;
+
+    // numRanked: how many of the best tours ranked() must return in order
+    // (at least numElites; e.g. the number of migrants).
+    Selector(SelectionType type, int populationSize, int numElites, int tournamentSize, int numRanked = 0)
+        : type_(type), populationSize_(populationSize),
+          numElites_(std::max(0, std::min(numElites, populationSize - 1))),
+          numRanked_(std::max(1, std::min(std::max(numRanked, numElites_), populationSize))),
+          tournamentSize_(std::max(1, tournamentSize)), order_(populationSize) {
+        truncation_ = std::min(populationSize, std::max(numRanked_, static_cast<int>(kTruncationFraction * populationSize)));
+        if (type_ == SelectionType::Sus) {
+            pool_.resize(2 * static_cast<size_t>(populationSize));
+        }
+    }
+
+    SelectionType type() const { return type_; }
+    int numElites() const { return numElites_; }
+
+    // Orders the elite cut and builds the sampling tables for this generation.
+    void prepare(const double* lengths, Rng& rng) {
+        lengths_ = lengths;
+        std::iota(order_.begin(), order_.end(), 0);
+        auto shorter = [lengths](int a, int b) { return lengths[a] < lengths[b] || (lengths[a] == lengths[b] && a < b); };
+        int candidates = populationSize_;
+        if (type_ == SelectionType::Truncation && truncation_ < populationSize_) {
+            std::nth_element(order_.begin(), order_.begin() + truncation_, order_.end(), shorter);
+            candidates = truncation_;
+        }
+        if (numRanked_ < candidates) {
+            std::nth_element(order_.begin(), order_.begin() + numRanked_, order_.begin() + candidates, shorter);
+        }
+        std::sort(order_.begin(), order_.begin() + numRanked_, shorter);
+
+        if (type_ == SelectionType::Sus) {
+            double total = 0.0;
+            for (int i = 0; i < populationSize_; ++i) {
+                total += 1.0 / lengths[i];
+            }
+            const int picks = static_cast<int>(pool_.size());
+            const double step = total / picks;
+            double pointer = rng.uniform() * step;
+            double cumulative = 0.0;
+            int i = 0;
+            for (int p = 0; p < picks; ++p) {
+                while (i + 1 < populationSize_ && cumulative + 1.0 / lengths[i] <= pointer) {
+                    cumulative += 1.0 / lengths[i];
+                    ++i;
+                }
+                pool_[p] = i;
+                pointer += step;
+            }
+            rng.shuffle(pool_.data(), picks);
+        }
+    }
+
+    // The numRanked best tours, best first; ranked()[0] is the best of the generation.
+    const int* ranked() const { return order_.data(); }
+    int best() const { return order_[0]; }
+
+    // Parents of the child bred into `slot`.
+    void parents(int slot, Rng& rng, int& parent1, int& parent2) const {
+        if (type_ == SelectionType::Sus) {
+            parent1 = pool_[2 * static_cast<size_t>(slot)];
+            parent2 = pool_[2 * static_cast<size_t>(slot) + 1];
+            return;
+        }
+        parent1 = select(rng);
+        parent2 = select(rng);
+    }
+
+private:
+    int select(Rng& rng) const {
+        switch (type_) {
+        case SelectionType::Tournament: {
+            int winner = rng.below(populationSize_);
+            for (int t = 1; t < tournamentSize_; ++t) {
+                int challenger = rng.below(populationSize_);
+                if (lengths_[challenger] < lengths_[winner]) {
+                    winner = challenger;
+                }
+            }
+            return winner;
+        }
+        case SelectionType::Rank: {
+            int a = rng.below(populationSize_);
+            int b = rng.below(populationSize_);
+            bool aFitter = lengths_[a] < lengths_[b];
+            return rng.chance(kRankPressure / 2.0) == aFitter ? a : b;
+        }
+        case SelectionType::Truncation:
+            return order_[rng.below(truncation_)];
+        case SelectionType::Sus:
+            break;
+        }
+        return rng.below(populationSize_);
+    }
+
+    SelectionType type_;
+    int populationSize_;
+    int numElites_;
+    int numRanked_;
+    int tournamentSize_;
+    int truncation_;
+    const double* lengths_ = nullptr;
+    std::vector<int> order_;
+    std::vector<int> pool_;  // SUS: two parents per slot, shuffled
+};
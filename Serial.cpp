@@ -1,88 +1,216 @@
 #include <iostream>
-#include <fstream>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <ctime>
+#include <chrono>
 #include <limits>
-#include <ctime> 
+#include <type_traits>
+#include "Options.h"
+#include "TspLoader.h"
+#include "Random.h"
+#include "Crossover.h"
+#include "Mutation.h"
+#include "DistanceCache.h"
+#include "NeighborLists.h"
+#include "Population.h"
+#include "TourKernel.h"
+#include "LocalSearch.h"
+#include "Selection.h"
+#include "Seeding.h"
+#include "TargetTimer.h"
+#include "Dispatch.h"
+#include "RunReport.h"
+#include "Telemetry.h"
+#include "Termination.h"
+#include "Checkpoint.h"
+#include "TourHash.h"
 
 using namespace std;
 
-struct City {
-    int id;
-    double x, y;
-};
-
-double calculateDistance(const City& city1, const City& city2) {
-    double dx = city1.x - city2.x;
-    double dy = city1.y - city2.y;
-    return sqrt(dx * dx + dy * dy);
-}
-
-double calculateTotalDistance(const vector<int>& route, const vector<City>& cities) {
-    double totalDistance = 0.0;
-    int numCities = route.size();
-
-    for (int i = 0; i < numCities - 1; ++i) {
-        totalDistance += calculateDistance(cities[route[i]], cities[route[i + 1]]);
-    }
-
-    totalDistance += calculateDistance(cities[route[numCities - 1]], cities[route[0]]);
-
-    return totalDistance;
-}
-
-vector<int> generateRandomRoute(int numCities) {
-    vector<int> route(numCities);
-    for (int i = 0; i < numCities; ++i) {
-        route[i] = i;
-    }
-    random_shuffle(route.begin(), route.end());
-    return route;
-}
-
-vector<int> crossover(const vector<int>& parent1, const vector<int>& parent2) {
-    int numCities = parent1.size();
-    vector<int> child(numCities, -1);
-
-    int startPos = rand() % numCities;
-    int endPos = rand() % numCities;
+// The GA itself, compiled once per tour index type and distance functor (see Dispatch.h).
+template <typename Index, typename Distance>
+StopResult evolve(const Options& options, const TspInstance& instance, const DistanceCache& distances, const NeighborLists& neighbors,
+    const TourKernel& tourKernel, const Distance& distance, vector<int>& bestRoute, double& bestDistance, TargetTimer& targetTimer,
+    Termination& termination, Telemetry& telemetry, Checkpointer& checkpointer, const CheckpointFile* resume,
+    TourHashStats& hashStats) {
+    const int numCities = instance.numCities();
+    int populationSize = options.populationSize;
+    double mutationRate = options.mutationRate;
+    double crossoverRate = options.crossoverRate;
+    CrossoverType crossoverType = options.crossoverType;
+    MutationType mutationType = options.mutationType;
+
+    // All tours live in one contiguous arena holding this and the next generation
+    Population<Index> population(populationSize, numCities);
+    Rng rng(options.seed);
+    LocalSearch localSearch;
+    CheckpointState checkpoint;
+    int firstGeneration = 0;
+    long long evaluations = 0;
+    targetTimer.restart();
+    if (resume != nullptr) {
+        // Continue a checkpointed run exactly where it left off
+        resume->restore(population, checkpoint);
+        rng = checkpoint.rng;
+        firstGeneration = checkpoint.generation;
+        evaluations = checkpoint.evaluations;
+        bestRoute = checkpoint.bestRoute;
+        bestDistance = checkpoint.bestLength;
+        targetTimer.update(bestDistance);
+        termination.restoreProgress(checkpoint.progressBest, checkpoint.lastImprovement);
+        printResumeReport(cout, checkpointer.path(), firstGeneration);
+    } else {
+        Seeder seeder(instance, neighbors, distances);
+        seeder.seed(population, options.seeding, options.seed, 0);
+        tourKernel.evaluate(population, distance);
+        double seedingSeconds = targetTimer.elapsedSeconds();
+
+        // A memetic run starts from local optima
+        if (options.localSearch != LocalSearchMode::None) {
+            for (int i = 0; i < populationSize; ++i) {
+                population.length(i) += localSearch.improve(population[i], numCities, neighbors, distance);
+            }
+        }
 
-    if (startPos > endPos) {
-        swap(startPos, endPos);
+        printSeedingReport(cout, options.seeding, population, seedingSeconds);
     }
 
-    for (int i = startPos; i <= endPos; ++i) {
-        child[i] = parent1[i];
+    // Tour hashes follow the population; the cache is only consulted for crossover children
+    TourHashes hashes = options.tourHash.enabled() ? TourHashes(populationSize) : TourHashes();
+    FitnessCache fitnessCache(options.tourHash.cacheEntries);
+    if (hashes.enabled()) {
+        hashes.compute(population);
     }
 
-    int currentIndex = 0;
-    for (int i = 0; i < numCities; ++i) {
-        if (child[i] == -1) {
-            while (find(child.begin(), child.end(), parent2[currentIndex]) != child.end()) {
-                currentIndex = (currentIndex + 1) % numCities;
+    CrossoverScratch crossoverScratch;
+    Selector selector(options.selection, populationSize, options.numElites, options.tournamentSize);
+    vector<int> statsScratch;
+
+    // The state a generation starts from, handed to the checkpoint writer (see Checkpoint.h)
+    auto saveCheckpoint = [&](int generation, const Rng& generationRng) {
+        checkpoint.generation = generation;
+        checkpoint.evaluations = evaluations;
+        checkpoint.bestRoute = bestRoute;
+        checkpoint.bestLength = bestDistance;
+        checkpoint.progressBest = termination.progressBest();
+        checkpoint.lastImprovement = termination.lastImprovement();
+        checkpoint.rng = generationRng;
+        checkpointer.save(population, checkpoint);
+    };
+
+    // Main Genetic Algorithm loop, until a stop condition holds (see Termination.h)
+    telemetry.start(firstGeneration);
+    for (int generation = firstGeneration;; ++generation) {
+        // Tour lengths are cached per individual and only updated incrementally;
+        // selection reads them in place and orders only the elite cut
+        const Rng generationRng = rng;
+        selector.prepare(population.lengths(), rng);
+        const int best = selector.best();
+        if (population.length(best) < bestDistance) {
+            bestRoute.assign(population[best], population[best] + numCities);
+            bestDistance = population.length(best);
+            targetTimer.update(bestDistance);
+        }
+        const bool traced = telemetry.due(generation);
+        const bool measured = termination.measuresDiversity(generation);
+        const GenerationStats stats = traced || measured ? generationStats(population, best, statsScratch) : GenerationStats();
+        const StopReason reason = termination.check(generation, bestDistance, evaluations,
+            measured && termination.diversityCollapsed(stats.diversity));
+        if (reason != StopReason::None) {
+            if (telemetry.enabled()) {
+                telemetry.record(generation, traced || measured ? stats : generationStats(population, best, statsScratch));
             }
-            child[i] = parent2[currentIndex];
-            currentIndex = (currentIndex + 1) % numCities;
+            saveCheckpoint(generation, generationRng);
+            hashStats.add(fitnessCache);
+            hashStats.duplicates = hashes.duplicates();
+            return { reason, generation };
         }
-    }
+        if (checkpointer.due(generation, firstGeneration)) {
+            saveCheckpoint(generation, generationRng);
+        }
+        telemetry.lap(Phase::Selection);
 
-    return child;
-}
+        // Elitism: Keep the best routes from the previous generation
+        for (int e = 0; e < selector.numElites(); ++e) {
+            population.carryOver(selector.ranked()[e], e);
+            if (hashes.enabled()) {
+                hashes.carryOver(selector.ranked()[e], e);
+            }
+            if (shouldImprove(options.localSearch, options.localSearchRate, e, populationSize, rng)) {
+                telemetry.lap(Phase::Selection);
+                population.nextLength(e) += localSearch.improve(population.next(e), numCities, neighbors, distance);
+                if (hashes.enabled()) {
+                    hashes.next(e) = tourHash(population.next(e), numCities);
+                }
+                telemetry.lap(Phase::LocalSearch);
+            }
+        }
+        telemetry.lap(Phase::Selection);
 
-void mutate(vector<int>& route, double mutationRate) {
-    int numCities = route.size();
-    for (int i = 0; i < numCities; ++i) {
-        if (rand() / static_cast<double>(RAND_MAX) < mutationRate) {
-            int j = rand() % numCities;
-            swap(route[i], route[j]);
+        // Select parents and create offspring
+        for (int i = selector.numElites(); i < populationSize; ++i) {
+            int parent1, parent2;
+            selector.parents(i, rng, parent1, parent2);
+            telemetry.lap(Phase::Selection);
+            if (rng.chance(crossoverRate)) {
+                crossover(crossoverType, population[parent1], population[parent2],
+                    population.next(i), numCities, crossoverScratch, rng);
+                telemetry.lap(Phase::Crossover);
+                population.nextLength(i) = hashes.enabled()
+                    ? scoreTour(tourKernel, population.next(i), numCities, distance, fitnessCache, hashes.next(i))
+                    : tourKernel.tourLength(population.next(i), numCities, distance);
+                telemetry.lap(Phase::Evaluation);
+            } else {
+                population.carryOver(parent1, i);
+                if (hashes.enabled()) {
+                    hashes.carryOver(parent1, i);
+                }
+            }
+            population.nextLength(i) += hashes.enabled()
+                ? mutate(mutationType, population.next(i), numCities, mutationRate, distance, rng, hashes.next(i))
+                : mutate(mutationType, population.next(i), numCities, mutationRate, distance, rng);
+            telemetry.lap(Phase::Mutation);
+            if (shouldImprove(options.localSearch, options.localSearchRate, i, populationSize, rng)) {
+                population.nextLength(i) += localSearch.improve(population.next(i), numCities, neighbors, distance,
+                    population[parent1], population[parent2]);
+                if (hashes.enabled()) {
+                    hashes.next(i) = tourHash(population.next(i), numCities);
+                }
+                telemetry.lap(Phase::LocalSearch);
+            }
+            if (fitnessCache.enabled()) {
+                fitnessCache.store(hashes.next(i), population.nextLength(i));
+            }
+        }
+        telemetry.countEvaluations(populationSize - selector.numElites());
+        evaluations += populationSize - selector.numElites();
+
+        population.swapGenerations();
+        if (hashes.enabled()) {
+            hashes.swapGenerations();
+            if (options.tourHash.dedup) {
+                hashes.replaceDuplicates(population, distance, rng);
+            }
+        }
+        if (traced) {
+            telemetry.record(generation, stats);
         }
     }
 }
 
-int main() {
-    srand(42);
+int main(int argc, char* argv[]) {
+    Options options;
+    string error;
+    if (!parseOptions(argc, argv, options, error)) {
+        cerr << error << endl;
+        printUsage(cerr, argv[0]);
+        return 1;
+    }
+    if (options.showHelp) {
+        printUsage(cout, argv[0]);
+        return 0;
+    }
 
     const string LIGHT_BLUE = "\033[94m";
     const string GREEN = "\033[32m";
@@ -93,81 +221,79 @@ int main() {
     cout << GREEN + "           TRAVELING SALESMAN PROBLEM     " + RESET << endl;
     cout << GREEN + "================================================" + RESET << endl << endl;
 
-    // Record the start time
-    time_t startTime = time(nullptr);
+    // Record the start time; the time limit counts from here
+    auto startTime = chrono::steady_clock::now();
+    Termination termination(options.stop, options.numGenerations, options.targetLength);
+    installInterruptHandler();
 
-    ifstream inputFile("att532.tsp"); // Replace with the actual TSP file name
-    if (!inputFile) {
-        cerr << "Failed to open input file." << endl;
+    TspInstance instance;
+    bool fromCache = false;
+    auto loadStart = chrono::steady_clock::now();
+    if (!loadTspInstance(options.instancePath, instance, error, options.useCache, true, &fromCache)) {
+        cerr << error << endl;
         return 1;
     }
-
-    string line;
-    vector<City> cities;
-
-    // Skip lines until the problem data begins
-    while (inputFile >> line) {
-        if (line == "NODE_COORD_SECTION") {
-            break;
-        }
-    }
-
-    // Read the coordinates from the TSP file
-    while (inputFile >> line) {
-        if (line == "EOF") {
-            break;
-        }
-        City city;
-        inputFile >> city.id >> city.x >> city.y;
-        cities.push_back(city);
-    }
-
-    int numCities = cities.size();
-    int populationSize = 100;
-    int numGenerations = 100;
-    double mutationRate = 0.01;
+    double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - loadStart).count();
+
+    int numCities = instance.numCities();
+
+    // Precompute the distance cache, the candidate neighbour lists and the SoA tour kernel
+    DistanceCache distances(instance);
+    NeighborLists neighbors(instance);
+    TourKernel tourKernel(instance, distances);
+    cout << LIGHT_BLUE << "Instance: " << instance.name << " (" << numCities << " cities, "
+        << edgeWeightTypeName(instance.weightType) << "), loaded in " << loadSeconds * 1000.0 << " ms"
+        << (fromCache ? " from cache" : "") << endl;
+    cout << "Distance cache: " << distanceLayoutName(distances.layout()) << ", "
+        << distances.memoryBytes() / 1048576.0 << " MB, built in " << distances.buildSeconds() * 1000.0 << " ms" << endl;
+    cout << "Neighbor lists: k = " << neighbors.k() << ", " << neighbors.memoryBytes() / 1048576.0
+        << " MB, built in " << neighbors.buildSeconds() * 1000.0 << " ms" << endl;
+    cout << "Tour kernel: " << tourKernel.description() << RESET << endl << endl;
 
     vector<int> bestRoute;
     double bestDistance = numeric_limits<double>::max();
-
-    // Initialize the population
-    vector<vector<int>> population(populationSize);
-    for (int i = 0; i < populationSize; ++i) {
-        population[i] = generateRandomRoute(numCities);
+    TargetTimer targetTimer(options.targetLength);
+    Telemetry telemetry;
+    StopResult stop;
+    TourHashStats hashStats;
+    if (!telemetry.open(options.tracePath, options.traceFormat, options.traceInterval, "serial", 0, 1, error)) {
+        cerr << error << endl;
+        return 1;
     }
 
-    // Main Genetic Algorithm loop
-    for (int generation = 0; generation < numGenerations; ++generation) {
-        vector<pair<int, double>> fitness;
-        for (int i = 0; i < populationSize; ++i) {
-            double distance = calculateTotalDistance(population[i], cities);
-            fitness.push_back(make_pair(i, 1.0 / distance));
-        }
-
-        sort(fitness.begin(), fitness.end(), [](const pair<int, double>& a, const pair<int, double>& b) {
-            return a.second > b.second;
-            });
-
-        vector<vector<int>> newPopulation(populationSize);
-
-        // Elitism: Keep the best route from the previous generation
-        newPopulation[0] = population[fitness[0].first];
-        if (1.0 / fitness[0].second < bestDistance) {
-            bestRoute = population[fitness[0].first];
-            bestDistance = 1.0 / fitness[0].second;
-        }
+    // Checkpoints are written by a background thread; --resume picks up the last one
+    CheckpointWriter checkpointWriter;
+    Checkpointer checkpointer(options.checkpoint, checkpointWriter, { instance.name, numCities, options.seed, 0, 1, options.populationSize });
+    const bool resume = options.checkpoint.resume && checkpointExists(checkpointer.path());
+    if (options.checkpoint.resume && !resume) {
+        cout << "No checkpoint at " << checkpointer.path() << ", starting a new run" << endl;
+    }
 
-        // Select parents and create offspring
-        for (int i = 1; i < populationSize; ++i) {
-            int parent1 = fitness[i - 1].first;
-            int parent2 = fitness[i].first;
-            newPopulation[i] = crossover(population[parent1], population[parent2]);
-            mutate(newPopulation[i], mutationRate);
+    auto gaStart = chrono::steady_clock::now();
+    int status = dispatchSpecialization(instance, distances, [&](auto index, const auto& distance) {
+        using Index = decltype(index);
+        cout << LIGHT_BLUE << "Specialization: " << specializationName<Index, decay_t<decltype(distance)>>() << RESET << endl;
+        CheckpointFile checkpoint;
+        if (resume && !checkpoint.open<Index>(checkpointer.path(), checkpointer.id(), error)) {
+            cerr << error << endl;
+            return 1;
         }
-
-        population = newPopulation;
+        stop = evolve<Index>(options, instance, distances, neighbors, tourKernel, distance, bestRoute, bestDistance, targetTimer,
+            termination, telemetry, checkpointer, resume ? &checkpoint : nullptr, hashStats);
+        return 0;
+    });
+    double gaSeconds = chrono::duration<double>(chrono::steady_clock::now() - gaStart).count();
+    if (status != 0) {
+        return 1;
+    }
+    if (!checkpointWriter.finish(error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    if (!telemetry.close(error)) {
+        cerr << error << endl;
+        return 1;
     }
-
 
     cout << YELLOW + "\nResults:" + RESET << endl;
     cout << LIGHT_BLUE + "Best route:\n";
@@ -176,11 +302,22 @@ int main() {
     }
     cout << RESET << "\n\n";
     cout << GREEN << "Total distance: " << bestDistance << RESET << endl;
+    printTimeToTarget(cout, targetTimer);
+    printStopReason(cout, stop.reason, stop.generations, gaSeconds);
+    printTourHashReport(cout, options.tourHash, hashStats);
 
-    time_t endTime = time(nullptr);
-    double duration = difftime(endTime, startTime);
+    double duration = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
     cout << YELLOW + "Time taken by function: " << duration << " seconds" + RESET << endl;
 
+    if (!options.reportPath.empty()) {
+        RunReport report{ "serial", instance.name, numCities, 1, options.populationSize, stop.generations,
+            options.seed, duration, gaSeconds, bestDistance, targetTimer.seconds(), stopReasonName(stop.reason) };
+        if (!appendRunReport(options.reportPath, report, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+    }
+
     cout << GREEN + "\nThank you for using the Genetic Algorithm TSP Solver!" + RESET << endl;
     cout << GREEN + "===========================================" + RESET << endl;
 
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <omp.h>
+#include "Options.h"
+#include "TspInstance.h"
+#include "Random.h"
+#include "Crossover.h"
+#include "Mutation.h"
+#include "DistanceCache.h"
+#include "NeighborLists.h"
+#include "Population.h"
+#include "TourKernel.h"
+#include "LocalSearch.h"
+#include "Selection.h"
+#include "Seeding.h"
+#include "Dispatch.h"
+#include "Telemetry.h"
+#include "Termination.h"
+
+// The GA as a library call, for drivers that solve many instances (Batch.cpp)
+// or many parts of one (Decompose.cpp) rather than one instance per process.
+//
+// No telemetry, checkpoints or tour hashing; the GA options of Options.h and
+// its stop conditions apply to each call. Every child draws from its own
+// random stream (generation, slot), as in OpenMP.cpp, so an instance gets the
+// same tour on one thread or on a team of numThreads.
+
+// The first option given that solve() does not support, or nullptr.
+inline const char* unsupportedBySolver(const Options& options) {
+    return options.engine != Engine::Generational ? "--engine steady"
+        : !options.tracePath.empty() ? "--trace"
+        : options.checkpoint.enabled() ? "--checkpoint"
+        : options.tourHash.enabled() ? "--dedup and --fitness-cache"
+        : nullptr;
+}
+
+struct SolveResult {
+    int generations = 0;
+    double length = 0.0;
+    StopReason reason = StopReason::None;
+    std::vector<int> tour;
+};
+
+// The GA for one instance, compiled once per tour index type and distance functor (see Dispatch.h).
+template <typename Index, typename Distance>
+void solve(const Options& options, int numThreads, const TspInstance& instance, const DistanceCache& distances,
+    const NeighborLists& neighbors, const TourKernel& tourKernel, const Distance& distance, SolveResult& result) {
+    const int numCities = instance.numCities();
+    const int populationSize = options.populationSize;
+    Population<Index> population(populationSize, numCities);
+    Seeder seeder(instance, neighbors, distances);
+    seeder.seed(population, options.seeding, options.seed, 0);
+    tourKernel.evaluate(population, distance);
+
+    std::vector<CrossoverScratch> crossoverScratch(numThreads);
+    std::vector<LocalSearch> localSearch(numThreads);
+    if (options.localSearch != LocalSearchMode::None) {
+        for (int i = 0; i < populationSize; ++i) {
+            population.length(i) += localSearch[0].improve(population[i], numCities, neighbors, distance);
+        }
+    }
+
+    Selector selector(options.selection, populationSize, options.numElites, options.tournamentSize);
+    Termination termination(options.stop, options.numGenerations, options.targetLength);
+    std::vector<int> statsScratch;
+    double bestLength = std::numeric_limits<double>::max();
+    long long evaluations = 0;
+
+    // Slot i of the next generation: an elite copy or a child, from stream (generation, i)
+    auto breed = [&](int generation, int i, int thread) {
+        Rng rng(options.seed, generation + 1, i);
+        if (i < selector.numElites()) {
+            population.carryOver(selector.ranked()[i], i);
+            if (shouldImprove(options.localSearch, options.localSearchRate, i, populationSize, rng)) {
+                population.nextLength(i) += localSearch[thread].improve(population.next(i), numCities, neighbors, distance);
+            }
+            return;
+        }
+        int parent1, parent2;
+        selector.parents(i, rng, parent1, parent2);
+        if (rng.chance(options.crossoverRate)) {
+            crossover(options.crossoverType, population[parent1], population[parent2], population.next(i), numCities,
+                crossoverScratch[thread], rng);
+            population.nextLength(i) = tourKernel.tourLength(population.next(i), numCities, distance);
+        } else {
+            population.carryOver(parent1, i);
+        }
+        population.nextLength(i) += mutate(options.mutationType, population.next(i), numCities, options.mutationRate, distance, rng);
+        if (shouldImprove(options.localSearch, options.localSearchRate, i, populationSize, rng)) {
+            population.nextLength(i) += localSearch[thread].improve(population.next(i), numCities, neighbors, distance,
+                population[parent1], population[parent2]);
+        }
+    };
+
+    for (int generation = 0;; ++generation) {
+        Rng selectionRng(options.seed, generation + 1, populationSize);
+        selector.prepare(population.lengths(), selectionRng);
+        const int best = selector.best();
+        if (population.length(best) < bestLength) {
+            bestLength = population.length(best);
+            result.tour.assign(population[best], population[best] + numCities);
+        }
+        const bool measured = termination.measuresDiversity(generation);
+        const double diversity = measured ? generationStats(population, best, statsScratch).diversity : 0.0;
+        const StopReason reason = termination.check(generation, bestLength, evaluations,
+            measured && termination.diversityCollapsed(diversity));
+        if (reason != StopReason::None) {
+            result.length = bestLength;
+            result.generations = generation;
+            result.reason = reason;
+            return;
+        }
+
+        // A small instance stays on its pool worker; a large one breeds on every thread
+        if (numThreads > 1) {
+            #pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+            for (int i = 0; i < populationSize; ++i) {
+                breed(generation, i, omp_get_thread_num());
+            }
+        } else {
+            for (int i = 0; i < populationSize; ++i) {
+                breed(generation, i, 0);
+            }
+        }
+        evaluations += populationSize - selector.numElites();
+        population.swapGenerations();
+    }
+}
+
+// Precomputes what the GA needs and solves an instance that is already loaded.
+// The OpenMP regions of the precomputation and seeding get numThreads threads:
+// the setting is per calling thread, so a pool worker stays on one.
+inline void solveInstance(const Options& options, int numThreads, const TspInstance& instance, SolveResult& result) {
+    omp_set_num_threads(numThreads);
+    DistanceCache distances(instance);
+    NeighborLists neighbors(instance);
+    TourKernel tourKernel(instance, distances);
+    dispatchSpecialization(instance, distances, [&](auto index, const auto& distance) {
+        solve<decltype(index)>(options, numThreads, instance, distances, neighbors, tourKernel, distance, result);
+        return 0;
+    });
+}
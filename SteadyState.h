@@ -0,0 +1,138 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include "Population.h"
+#include "Random.h"
+
+// Steady-state engine for the OpenMP program (--engine steady).
+//
+// The generational engine breeds a whole generation and waits for its
+// slowest child before the next can start. Here there are no generations:
+// every worker repeatedly picks two parents by tournament, breeds and scores
+// a child, and replaces the loser of a reverse tournament if the child is
+// shorter. The workers of a WorkStealingPool draw the children in chunks
+// from one counter (runWhile), so a worker that drew cheap children simply
+// takes more chunks, and nothing waits for anything but the end of the run.
+//
+// SteadyPopulation is the shared population. Lengths are atomics, so
+// tournaments read them without a lock; each tour has a spin lock of its
+// own, held only while a parent is copied out or a child copied in.
+// Replacement re-checks the victim's length under its lock, so the best
+// tour is never replaced by a worse one and no elites are needed. The
+// interleaving of workers differs from run to run, so a run is reproducible
+// for one thread only.
+//
+// The MPI program's evaluation farm (MPI.CPP) runs the same replacement on
+// rank 0 and has the other ranks breed the children in batches.
+
+constexpr int kSteadyChunk = 16;  // children per scheduled task
+
+enum class Engine {
+    Generational,  // bulk-synchronous generations (default)
+    Steady         // asynchronous steady-state replacement
+};
+
+inline const char* engineName(Engine engine) {
+    switch (engine) {
+    case Engine::Generational: return "generational";
+    case Engine::Steady:       return "steady";
+    }
+    return "unknown";
+}
+
+inline bool parseEngine(const std::string& name, Engine& engine) {
+    for (Engine candidate : { Engine::Generational, Engine::Steady }) {
+        if (name == engineName(candidate)) {
+            engine = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename Index>
+class SteadyPopulation {
+public:
+    // Takes over the tours and cached lengths of the current generation of `population`.
+    explicit SteadyPopulation(Population<Index>& population)
+        : population_(population), size_(population.size()), numCities_(population.numCities()),
+          lengths_(new std::atomic<double>[population.size()]), locks_(new Lock[population.size()]) {
+        for (int i = 0; i < size_; ++i) {
+            lengths_[i].store(population.length(i), std::memory_order_relaxed);
+        }
+    }
+
+    int size() const { return size_; }
+    double length(int slot) const { return lengths_[slot].load(std::memory_order_relaxed); }
+
+    // Slot of the shortest (or, for a reverse tournament, the longest) of `rounds` random tours.
+    int tournament(Rng& rng, int rounds, bool reverse) const {
+        int winner = static_cast<int>(rng.below(size_));
+        for (int r = 1; r < rounds; ++r) {
+            const int candidate = static_cast<int>(rng.below(size_));
+            if (reverse ? length(candidate) > length(winner) : length(candidate) < length(winner)) {
+                winner = candidate;
+            }
+        }
+        return winner;
+    }
+
+    // Copies the tour of `slot` to `route`; returns its length.
+    double copyOut(int slot, Index* route) const {
+        lock(slot);
+        std::copy(population_[slot], population_[slot] + numCities_, route);
+        const double result = length(slot);
+        unlock(slot);
+        return result;
+    }
+
+    // Puts `route` into `slot` if it is shorter than the tour there; returns whether it was.
+    bool replace(int slot, const Index* route, double routeLength) {
+        if (!(routeLength < length(slot))) {
+            return false;
+        }
+        lock(slot);
+        const bool shorter = routeLength < length(slot);
+        if (shorter) {
+            std::copy(route, route + numCities_, population_[slot]);
+            lengths_[slot].store(routeLength, std::memory_order_relaxed);
+        }
+        unlock(slot);
+        return shorter;
+    }
+
+    // Writes the lengths back to the population, once no worker is running.
+    void finish() {
+        for (int i = 0; i < size_; ++i) {
+            population_.length(i) = length(i);
+        }
+    }
+
+private:
+    struct alignas(kCacheLineBytes) Lock {
+        std::atomic<bool> held{ false };
+    };
+
+    void lock(int slot) const {
+        while (locks_[slot].held.exchange(true, std::memory_order_acquire)) {
+            while (locks_[slot].held.load(std::memory_order_relaxed)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void unlock(int slot) const {
+        locks_[slot].held.store(false, std::memory_order_release);
+    }
+
+    Population<Index>& population_;
+    int size_;
+    int numCities_;
+    std::unique_ptr<std::atomic<double>[]> lengths_;
+    std::unique_ptr<Lock[]> locks_;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+// Records when the best tour first reaches a target length (time to target).
+// update() may be called from any number of threads; the first call at or
+// below the target wins. A target of 0 disables the timer.
+
+class TargetTimer {
+public:
+    explicit TargetTimer(double target)
+        : target_(target), start_(std::chrono::steady_clock::now()) {}
+
+    bool enabled() const { return target_ > 0.0; }
+    double target() const { return target_; }
+
+    // Restarts the clock, e.g. before seeding the population.
+    void restart() { start_ = std::chrono::steady_clock::now(); }
+
+    void update(double bestLength) {
+        if (!enabled() || bestLength > target_ || reached()) {
+            return;
+        }
+        const double elapsed = elapsedSeconds();
+        double expected = -1.0;
+        seconds_.compare_exchange_strong(expected, elapsed, std::memory_order_acq_rel);
+    }
+
+    bool reached() const { return seconds_.load(std::memory_order_acquire) >= 0.0; }
+
+    // Seconds from restart() until the target was reached, or -1.
+    double seconds() const { return seconds_.load(std::memory_order_acquire); }
+
+    double elapsedSeconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    double target_;
+    std::chrono::steady_clock::time_point start_;
+    std::atomic<double> seconds_{ -1.0 };
+};
+
+inline void printTimeToTarget(std::ostream& out, double target, double seconds) {
+    if (target <= 0.0) {
+        return;
+    }
+    out << "Time to target " << target << ": ";
+    if (seconds >= 0.0) {
+        out << seconds << " s" << std::endl;
+    } else {
+        out << "not reached" << std::endl;
+    }
+}
+
+inline void printTimeToTarget(std::ostream& out, const TargetTimer& timer) {
+    printTimeToTarget(out, timer.target(), timer.seconds());
+}
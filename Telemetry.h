@@ -0,0 +1,303 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <numeric>
+#include "Population.h"
+
+// Per-worker hot-path telemetry, written as a streaming trace (--trace).
+//
+// Each worker (the serial loop, an OpenMP thread, a threaded island or an MPI
+// rank) owns one Telemetry and writes its own file, so nothing is shared or
+// locked. lap(phase) charges the time since the previous lap to `phase`, so
+// a phase boundary costs one clock read; a disabled Telemetry returns before
+// reading the clock. Every --trace-interval generations, and at the one the
+// run stops at, a worker appends one row with its cumulative phase times,
+// its evaluation count and rates, and the best and mean length and edge
+// diversity of the population it breeds. At the end mergeTraceParts() merges the per-worker
+// files into the --trace file, ordered by generation and worker.
+
+enum class TraceFormat { Csv, Json };
+
+inline const char* traceFormatName(TraceFormat format) {
+    return format == TraceFormat::Json ? "json" : "csv";
+}
+
+inline bool parseTraceFormat(const std::string& name, TraceFormat& format) {
+    for (TraceFormat candidate : { TraceFormat::Csv, TraceFormat::Json }) {
+        if (name == traceFormatName(candidate)) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+enum class Phase { Evaluation, Selection, Crossover, Mutation, LocalSearch, Migration, Wait, Count };
+
+constexpr int kNumPhases = static_cast<int>(Phase::Count);
+
+inline const char* phaseName(Phase phase) {
+    switch (phase) {
+    case Phase::Evaluation:  return "evaluation";
+    case Phase::Selection:   return "selection";
+    case Phase::Crossover:   return "crossover";
+    case Phase::Mutation:    return "mutation";
+    case Phase::LocalSearch: return "local_search";
+    case Phase::Migration:   return "migration";
+    case Phase::Wait:        return "wait";
+    case Phase::Count:       break;
+    }
+    return "unknown";
+}
+
+struct GenerationStats {
+    double best = 0.0;
+    double mean = 0.0;
+    double diversity = 0.0;  // mean fraction of edges a tour does not share with the best tour
+};
+
+// Best and mean length, and edge diversity against tour `best`: O(size * numCities).
+// `scratch` keeps the successor and predecessor arrays between calls.
+template <typename Index>
+GenerationStats generationStats(const Population<Index>& population, int best, std::vector<int>& scratch) {
+    const int size = population.size();
+    const int numCities = population.numCities();
+    const double* lengths = population.lengths();
+    GenerationStats stats;
+    stats.best = lengths[best];
+    stats.mean = std::accumulate(lengths, lengths + size, 0.0) / size;
+    if (size < 2 || numCities < 2) {
+        return stats;
+    }
+
+    scratch.resize(2 * static_cast<size_t>(numCities));
+    int* successor = scratch.data();
+    int* predecessor = successor + numCities;
+    const Index* reference = population[best];
+    for (int c = 0; c < numCities; ++c) {
+        const int next = reference[c + 1 < numCities ? c + 1 : 0];
+        successor[reference[c]] = next;
+        predecessor[next] = reference[c];
+    }
+
+    double distance = 0.0;
+    for (int i = 0; i < size; ++i) {
+        if (i == best) {
+            continue;
+        }
+        const Index* route = population[i];
+        int shared = 0;
+        for (int c = 0; c < numCities; ++c) {
+            const int a = route[c];
+            const int b = route[c + 1 < numCities ? c + 1 : 0];
+            shared += (successor[a] == b) | (predecessor[a] == b);
+        }
+        distance += 1.0 - static_cast<double>(shared) / numCities;
+    }
+    stats.diversity = distance / (size - 1);
+    return stats;
+}
+
+// File a worker writes while the run goes on; with one worker, the trace itself.
+inline std::string tracePartPath(const std::string& path, int worker, int numWorkers) {
+    return numWorkers > 1 ? path + ".part" + std::to_string(worker) : path;
+}
+
+class Telemetry {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A disabled Telemetry: nothing is timed or written.
+    Telemetry() = default;
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+    Telemetry(Telemetry&&) = default;
+
+    // Opens this worker's part of the trace; an empty path leaves it disabled.
+    bool open(const std::string& path, TraceFormat format, int interval, const char* program, int worker, int numWorkers,
+        std::string& error) {
+        if (path.empty()) {
+            return true;
+        }
+        const std::string partPath = tracePartPath(path, worker, numWorkers);
+        out_.open(partPath, std::ios::trunc);
+        if (!out_) {
+            error = "Cannot write the trace " + partPath;
+            return false;
+        }
+        enabled_ = true;
+        format_ = format;
+        interval_ = std::max(1, interval);
+        program_ = program;
+        worker_ = worker;
+        if (format_ == TraceFormat::Csv) {
+            out_ << traceCsvHeader() << '\n';
+        }
+        return true;
+    }
+
+    bool enabled() const { return enabled_; }
+
+    // Whether `generation` gets a row: every interval generations. The
+    // programs add a row for the generation the run stops at.
+    bool due(int generation) const {
+        return enabled_ && generation % interval_ == 0;
+    }
+
+    // Starts the clock of the whole trace, right before the first generation
+    // (firstGeneration, after a resume), which gens_per_sec counts from.
+    void start(int firstGeneration = 0) {
+        if (enabled_) {
+            start_ = mark_ = Clock::now();
+            firstGeneration_ = firstGeneration;
+        }
+    }
+
+    // Restarts the lap without charging the time since the last one, e.g. on
+    // entering a parallel region after another thread ran a serial part.
+    void resume() {
+        if (enabled_) {
+            mark_ = Clock::now();
+        }
+    }
+
+    void lap(Phase phase) {
+        if (enabled_) {
+            const Clock::time_point now = Clock::now();
+            seconds_[static_cast<int>(phase)] += std::chrono::duration<double>(now - mark_).count();
+            mark_ = now;
+        }
+    }
+
+    // Tours scored by this worker, in full or incrementally.
+    void countEvaluations(long long count) { evaluations_ += count; }
+
+    // Appends the row of `generation` and flushes it, so the trace can be followed live.
+    void record(int generation, const GenerationStats& stats) {
+        if (!enabled_) {
+            return;
+        }
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start_).count();
+        const double perSecond = elapsed > 0.0 ? 1.0 / elapsed : 0.0;
+        const int bred = generation + 1 - firstGeneration_;
+        std::ostringstream row;
+        row << std::setprecision(10);
+        if (format_ == TraceFormat::Csv) {
+            row << generation << ',' << program_ << ',' << worker_ << ',' << elapsed << ',' << stats.best << ','
+                << stats.mean << ',' << stats.diversity << ',' << evaluations_ << ',' << evaluations_ * perSecond << ','
+                << bred * perSecond;
+            for (double seconds : seconds_) {
+                row << ',' << seconds;
+            }
+        } else {
+            row << "{\"generation\": " << generation << ", \"program\": \"" << program_ << "\", \"worker\": " << worker_
+                << ", \"seconds\": " << elapsed << ", \"best\": " << stats.best << ", \"mean\": " << stats.mean
+                << ", \"diversity\": " << stats.diversity << ", \"evaluations\": " << evaluations_
+                << ", \"evals_per_sec\": " << evaluations_ * perSecond << ", \"gens_per_sec\": " << bred * perSecond;
+            for (int p = 0; p < kNumPhases; ++p) {
+                row << ", \"" << phaseName(static_cast<Phase>(p)) << "\": " << seconds_[p];
+            }
+            row << '}';
+        }
+        out_ << row.str() << std::endl;
+    }
+
+    bool close(std::string& error) {
+        if (!enabled_) {
+            return true;
+        }
+        out_.close();
+        if (!out_) {
+            error = "Cannot write the trace of worker " + std::to_string(worker_);
+            return false;
+        }
+        return true;
+    }
+
+    static std::string traceCsvHeader() {
+        std::string header = "generation,program,worker,seconds,best,mean,diversity,evaluations,evals_per_sec,gens_per_sec";
+        for (int p = 0; p < kNumPhases; ++p) {
+            header += ',';
+            header += phaseName(static_cast<Phase>(p));
+        }
+        return header;
+    }
+
+private:
+    bool enabled_ = false;
+    TraceFormat format_ = TraceFormat::Csv;
+    int interval_ = 1;
+    const char* program_ = "";
+    int worker_ = 0;
+    int firstGeneration_ = 0;
+    long long evaluations_ = 0;
+    double seconds_[kNumPhases] = {};
+    Clock::time_point start_;
+    Clock::time_point mark_;
+    std::ofstream out_;
+};
+
+// Generation number a trace row starts with, in either format.
+inline long traceRowGeneration(const std::string& row) {
+    const size_t digit = row.find_first_of("0123456789");
+    return digit == std::string::npos ? -1 : std::strtol(row.c_str() + digit, nullptr, 10);
+}
+
+// Merges the per-worker files of a trace into `path`, ordered by generation
+// and then worker, and removes them. Each part is already in generation order.
+inline bool mergeTraceParts(const std::string& path, TraceFormat format, int numWorkers, std::string& error) {
+    if (numWorkers <= 1) {
+        return true;
+    }
+    std::vector<std::ifstream> parts(numWorkers);
+    std::vector<std::string> rows(numWorkers);
+    std::vector<bool> pending(numWorkers, false);
+    for (int w = 0; w < numWorkers; ++w) {
+        parts[w].open(tracePartPath(path, w, numWorkers));
+        if (!parts[w]) {
+            error = "Cannot read the trace part " + tracePartPath(path, w, numWorkers);
+            return false;
+        }
+        if (format == TraceFormat::Csv) {
+            std::getline(parts[w], rows[w]);
+        }
+        pending[w] = static_cast<bool>(std::getline(parts[w], rows[w]));
+    }
+
+    std::ofstream out(path, std::ios::trunc);
+    if (format == TraceFormat::Csv) {
+        out << Telemetry::traceCsvHeader() << '\n';
+    }
+    for (;;) {
+        int next = -1;
+        for (int w = 0; w < numWorkers; ++w) {
+            if (pending[w] && (next < 0 || traceRowGeneration(rows[w]) < traceRowGeneration(rows[next]))) {
+                next = w;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+        out << rows[next] << '\n';
+        pending[next] = static_cast<bool>(std::getline(parts[next], rows[next]));
+    }
+    out.close();
+    if (!out) {
+        error = "Cannot write the trace " + path;
+        return false;
+    }
+    for (int w = 0; w < numWorkers; ++w) {
+        parts[w].close();
+        std::remove(tracePartPath(path, w, numWorkers).c_str());
+    }
+    return true;
+}
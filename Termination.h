@@ -0,0 +1,227 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <ostream>
+
+// Stop conditions of the anytime mode. A run ends at the first of:
+//
+//   generations   --generations N (0: no limit, another condition required)
+//   time          --time-limit S seconds after the program started
+//   target        --stop-at-target, once the best tour reaches --target
+//   stagnation    --stagnation N generations without a shorter best tour
+//   diversity     --min-diversity D, once edge diversity (see Telemetry.h)
+//                 falls below D, measured every --stop-check generations
+//   evaluations   --max-evaluations N tours bred in total
+//   interrupted   SIGINT or SIGTERM
+//
+// The best tour so far is kept throughout, so a run stopped early, including
+// by Ctrl-C, still reports its best tour. Termination holds one worker's
+// view; SharedStop lets threads agree on one decision without a lock, and
+// MPI.CPP agrees on one with a non-blocking reduction every --stop-check
+// generations (see StopVote there).
+
+struct StopConditions {
+    double timeLimit = 0.0;        // seconds since the program started; 0: none
+    bool stopAtTarget = false;     // stop once the best tour reaches the target length
+    int stagnation = 0;            // generations without improvement; 0: none
+    double minDiversity = 0.0;     // edge diversity floor; 0: none
+    long long maxEvaluations = 0;  // tours bred in total; 0: none
+    int checkInterval = 5;         // generations between diversity checks and MPI votes
+
+    bool any() const {
+        return timeLimit > 0.0 || stopAtTarget || stagnation > 0 || minDiversity > 0.0 || maxEvaluations > 0;
+    }
+};
+
+enum class StopReason { None, Generations, TimeLimit, Target, Stagnation, Diversity, Evaluations, Interrupted };
+
+inline const char* stopReasonName(StopReason reason) {
+    switch (reason) {
+    case StopReason::None:        return "none";
+    case StopReason::Generations: return "generations";
+    case StopReason::TimeLimit:   return "time limit";
+    case StopReason::Target:      return "target reached";
+    case StopReason::Stagnation:  return "stagnation";
+    case StopReason::Diversity:   return "diversity collapse";
+    case StopReason::Evaluations: return "evaluation limit";
+    case StopReason::Interrupted: return "interrupted";
+    }
+    return "unknown";
+}
+
+namespace detail {
+
+inline std::atomic<bool>& interruptFlag() {
+    static std::atomic<bool> flag{ false };
+    return flag;
+}
+
+inline void onInterrupt(int) {
+    interruptFlag().store(true, std::memory_order_relaxed);
+}
+
+}  // namespace detail
+
+// Lets SIGINT and SIGTERM end the run after the current generation instead of killing it.
+inline void installInterruptHandler() {
+    detail::interruptFlag();
+    std::signal(SIGINT, detail::onInterrupt);
+    std::signal(SIGTERM, detail::onInterrupt);
+}
+
+inline bool interruptRequested() {
+    return detail::interruptFlag().load(std::memory_order_relaxed);
+}
+
+class Termination {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Starts the deadline clock: construct it when the program starts.
+    Termination(const StopConditions& conditions, int maxGenerations, double targetLength)
+        : conditions_(conditions), maxGenerations_(maxGenerations), targetLength_(targetLength), start_(Clock::now()) {}
+
+    const StopConditions& conditions() const { return conditions_; }
+
+    double elapsedSeconds() const {
+        return std::chrono::duration<double>(Clock::now() - start_).count();
+    }
+
+    // Whether edge diversity must be measured before check() in this generation.
+    bool measuresDiversity(int generation) const {
+        return conditions_.minDiversity > 0.0 && generation % conditions_.checkInterval == 0;
+    }
+
+    bool diversityCollapsed(double diversity) const {
+        return conditions_.minDiversity > 0.0 && diversity < conditions_.minDiversity;
+    }
+
+    bool generationLimit(int generation) const {
+        return maxGenerations_ > 0 && generation >= maxGenerations_;
+    }
+
+    // Conditions on the wall clock, which workers do not see alike. `lookahead`
+    // seconds are added to the elapsed time, so a decision that takes effect
+    // later still lands before the deadline.
+    StopReason checkClock(double lookahead = 0.0) const {
+        if (interruptRequested()) {
+            return StopReason::Interrupted;
+        }
+        if (conditions_.timeLimit > 0.0 && elapsedSeconds() + lookahead >= conditions_.timeLimit) {
+            return StopReason::TimeLimit;
+        }
+        return StopReason::None;
+    }
+
+    // Conditions on the progress of the search, given the best length and the
+    // evaluation count after `generation` generations, and whether diversity
+    // has collapsed (only meaningful when measuresDiversity(generation)).
+    StopReason checkProgress(int generation, double best, long long evaluations, bool collapsed) {
+        if (best < bestLength_) {
+            bestLength_ = best;
+            lastImprovement_ = generation;
+        }
+        if (conditions_.stopAtTarget && targetLength_ > 0.0 && best <= targetLength_) {
+            return StopReason::Target;
+        }
+        if (conditions_.maxEvaluations > 0 && evaluations >= conditions_.maxEvaluations) {
+            return StopReason::Evaluations;
+        }
+        if (conditions_.stagnation > 0 && generation - lastImprovement_ >= conditions_.stagnation) {
+            return StopReason::Stagnation;
+        }
+        if (collapsed && measuresDiversity(generation)) {
+            return StopReason::Diversity;
+        }
+        return StopReason::None;
+    }
+
+    // The progress --stagnation counts from, saved and restored by checkpoints.
+    double progressBest() const { return bestLength_; }
+    int lastImprovement() const { return lastImprovement_; }
+
+    void restoreProgress(double best, int lastImprovement) {
+        bestLength_ = best;
+        lastImprovement_ = lastImprovement;
+    }
+
+    // Every condition, for a worker that decides alone.
+    StopReason check(int generation, double best, long long evaluations, bool collapsed) {
+        if (generationLimit(generation)) {
+            return StopReason::Generations;
+        }
+        const StopReason reason = checkClock();
+        return reason != StopReason::None ? reason : checkProgress(generation, best, evaluations, collapsed);
+    }
+
+private:
+    StopConditions conditions_;
+    int maxGenerations_;
+    double targetLength_;
+    Clock::time_point start_;
+    double bestLength_ = 1e300;
+    int lastImprovement_ = 0;
+};
+
+// One stop decision shared by threads. The first worker to see a condition
+// publishes it with a compare-and-swap; the others read it with one relaxed
+// load per generation and stop at their next generation.
+class SharedStop {
+public:
+    explicit SharedStop(int numWorkers) : numWorkers_(numWorkers) {}
+
+    SharedStop(const SharedStop&) = delete;
+    SharedStop& operator=(const SharedStop&) = delete;
+
+    StopReason reason() const { return static_cast<StopReason>(reason_.load(std::memory_order_relaxed)); }
+
+    void request(StopReason reason) {
+        int expected = static_cast<int>(StopReason::None);
+        reason_.compare_exchange_strong(expected, static_cast<int>(reason), std::memory_order_relaxed);
+    }
+
+    // Adds a worker's tours and returns the total bred by all workers.
+    long long addEvaluations(long long count) {
+        return evaluations_.fetch_add(count, std::memory_order_relaxed) + count;
+    }
+
+    // Updates whether one worker's diversity has collapsed (it was `wasCollapsed`);
+    // returns whether every worker's has.
+    bool updateCollapsed(bool wasCollapsed, bool collapsed) {
+        int count;
+        if (collapsed != wasCollapsed) {
+            count = collapsed_.fetch_add(collapsed ? 1 : -1, std::memory_order_relaxed) + (collapsed ? 1 : -1);
+        } else {
+            count = collapsed_.load(std::memory_order_relaxed);
+        }
+        return count >= numWorkers_;
+    }
+
+    // Records that a worker ran `generations` generations; generations() is the most any ran.
+    void finished(int generations) {
+        int current = generations_.load(std::memory_order_relaxed);
+        while (generations > current && !generations_.compare_exchange_weak(current, generations, std::memory_order_relaxed)) {
+        }
+    }
+
+    int generations() const { return generations_.load(std::memory_order_relaxed); }
+
+private:
+    int numWorkers_;
+    std::atomic<int> reason_{ static_cast<int>(StopReason::None) };
+    std::atomic<long long> evaluations_{ 0 };
+    std::atomic<int> collapsed_{ 0 };
+    std::atomic<int> generations_{ 0 };
+};
+
+// How a worker's run ended: the condition and the number of generations bred.
+struct StopResult {
+    StopReason reason = StopReason::None;
+    int generations = 0;
+};
+
+inline void printStopReason(std::ostream& out, StopReason reason, int generations, double seconds) {
+    out << "Stopped: " << stopReasonName(reason) << " after " << generations << " generations, " << seconds << " s" << std::endl;
+}
@@ -1,145 +1,308 @@
 #include <iostream>
-#include <fstream>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <ctime>
 #include <chrono>
 #include <thread>
-#include <mutex>
-#include <random>
-#include <queue>
-#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include "Options.h"
+#include "TspLoader.h"
+#include "Random.h"
+#include "Crossover.h"
+#include "Mutation.h"
+#include "DistanceCache.h"
+#include "NeighborLists.h"
+#include "Population.h"
+#include "TourKernel.h"
+#include "LocalSearch.h"
+#include "Selection.h"
+#include "MigrationChannel.h"
+#include "GlobalBest.h"
+#include "Seeding.h"
+#include "TargetTimer.h"
+#include "Dispatch.h"
+#include "RunReport.h"
+#include "Telemetry.h"
+#include "Termination.h"
+#include "Checkpoint.h"
+#include "TourHash.h"
 
 
 using namespace std;
 using namespace chrono;
 
-struct City {
-    int id;
-    double x, y;
+// What every island shares: read-only precomputed data, the migration ring and the global best.
+// Index and Distance are the specialisation picked by dispatchSpecialization().
+template <typename Index, typename Distance>
+struct IslandShared {
+    const DistanceCache& distances;
+    const Distance& distance;
+    const TourKernel& tourKernel;
+    const NeighborLists& neighbors;
+    const Seeder& seeder;
+    SeedingType seeding;
+    double mutationRate;
+    double crossoverRate;
+    SelectionType selection;
+    int tournamentSize;
+    int numElites;
+    CrossoverType crossoverType;
+    MutationType mutationType;
+    LocalSearchMode localSearch;
+    double localSearchRate;
+    uint64_t seed;
+    int migrationInterval;  // every migrationInterval generations an island sends its best
+    int numMigrants;        // numMigrants tours to the next island in the ring, at most the smallest island
+    vector<unique_ptr<MigrationChannel<Index>>>& channels;  // channels[i] carries island i -> i + 1
+    GlobalBest<Index>& globalBest;
+    TargetTimer& targetTimer;
+    vector<Telemetry>& telemetry;  // one per island
+    const Termination& termination;  // copied by every island
+    SharedStop& stop;               // the stop decision all islands follow
+    vector<Checkpointer>& checkpointers;      // one shard per island
+    const vector<CheckpointFile>* resume;     // the shards to continue from, or nullptr
+    const TourHashOptions& tourHash;
+    vector<TourHashStats>& hashStats;         // one per island
 };
 
-// Function to calculate distance between two cities
-double calculateDistance(const City& city1, const City& city2) {
-    double dx = city1.x - city2.x;
-    double dy = city1.y - city2.y;
-    return sqrt(dx * dx + dy * dy);
-}
-
-// Function to calculate total distance of a route
-double calculateTotalDistance(const vector<int>& route, const vector<City>& cities) {
-    double totalDistance = 0.0;
-    int numCities = route.size();
-
-    for (int i = 0; i < numCities - 1; ++i) {
-        totalDistance += calculateDistance(cities[route[i]], cities[route[i + 1]]);
-    }
-
-    totalDistance += calculateDistance(cities[route[numCities - 1]], cities[route[0]]);
-
-    return totalDistance;
-}
-
-// Function to generate a random route
-vector<int> generateRandomRoute(int numCities) {
-    vector<int> route(numCities);
-    for (int i = 0; i < numCities; ++i) {
-        route[i] = i;
-    }
-    random_device rd;
-    mt19937 g(rd());
-    shuffle(route.begin(), route.end(), g);
-    return route;
-}
-
-// Function for crossover between two parent routes
-vector<int> crossover(const vector<int>& parent1, const vector<int>& parent2) {
-    int numCities = parent1.size();
-    vector<int> child(numCities, -1);
-
-    int startPos = rand() % numCities;
-    int endPos = rand() % numCities;
-
-    if (startPos > endPos) {
-        swap(startPos, endPos);
+// One island: a persistent worker that owns its subpopulation, scratch and
+// random stream and runs complete generations without taking any lock.
+// Each island stops at its own generation limit; the first island to see
+// any other stop condition ends the run for all of them.
+// The migrants an island sends in the last generation of an epoch are taken
+// in by the next island at the start of the following epoch, which waits for
+// them on its incoming channel if its neighbour is behind: a point-to-point
+// wait rather than a barrier, which makes a seed give the same run on any
+// number of threads. Only a stop request ends such a wait early.
+template <typename Index, typename Distance>
+void geneticAlgorithm(const IslandShared<Index, Distance>& shared, int island, int islandSize) {
+    const int numCities = shared.distances.numCities();
+    const int numIslands = static_cast<int>(shared.channels.size());
+    MigrationChannel<Index>& outgoing = *shared.channels[island];
+    MigrationChannel<Index>& incoming = *shared.channels[(island + numIslands - 1) % numIslands];
+
+    Rng rng(shared.seed, 1, island);
+    CrossoverScratch crossoverScratch;
+    Population<Index> population(islandSize, numCities);
+    LocalSearch localSearch;
+    Termination termination = shared.termination;
+    Checkpointer& checkpointer = shared.checkpointers[island];
+    CheckpointState checkpoint;
+    int firstGeneration = 0;
+    long long bred = 0;         // by this island
+    long long evaluations = 0;  // bred by all islands, as of this island's last generation
+    if (shared.resume != nullptr) {
+        // Continue this island's shard; every migrant sent before the checkpoint is in it
+        (*shared.resume)[island].restore(population, checkpoint);
+        rng = checkpoint.rng;
+        firstGeneration = checkpoint.generation;
+        bred = checkpoint.evaluations;
+        evaluations = shared.stop.addEvaluations(bred);
+        if (!checkpoint.bestRoute.empty()) {
+            const vector<Index> route(checkpoint.bestRoute.begin(), checkpoint.bestRoute.end());
+            shared.globalBest.offer(route.data(), checkpoint.bestLength);
+        }
+        termination.restoreProgress(checkpoint.progressBest, checkpoint.lastImprovement);
+    } else {
+        shared.seeder.seed(population, shared.seeding, shared.seed, island);
+        shared.tourKernel.evaluate(population, shared.distance);
+
+        // A memetic run starts from local optima
+        if (shared.localSearch != LocalSearchMode::None) {
+            for (int i = 0; i < islandSize; ++i) {
+                population.length(i) += localSearch.improve(population[i], numCities, shared.neighbors, shared.distance);
+            }
+        }
     }
 
-    for (int i = startPos; i <= endPos; ++i) {
-        child[i] = parent1[i];
+    // Tour hashes follow the population; each island memoizes the tours it breeds
+    TourHashes hashes = shared.tourHash.enabled() ? TourHashes(islandSize) : TourHashes();
+    FitnessCache fitnessCache(shared.tourHash.cacheEntries);
+    if (hashes.enabled()) {
+        hashes.compute(population);
     }
 
-    int currentIndex = 0;
-    for (int i = 0; i < numCities; ++i) {
-        if (child[i] == -1) {
-            while (find(child.begin(), child.end(), parent2[currentIndex]) != child.end()) {
-                currentIndex = (currentIndex + 1) % numCities;
+    Selector selector(shared.selection, islandSize, shared.numElites, shared.tournamentSize, shared.numMigrants);
+    vector<Index> migrant(numCities);
+    Telemetry& telemetry = shared.telemetry[island];
+    vector<int> statsScratch;
+    bool collapsed = false;
+
+    // The island's state as a generation starts, with the global best as its best tour
+    vector<Index> globalRoute;
+    auto saveCheckpoint = [&](int generation, const Rng& generationRng) {
+        checkpoint.generation = generation;
+        checkpoint.evaluations = bred;
+        shared.globalBest.snapshot(globalRoute, checkpoint.bestLength);
+        if (checkpoint.bestLength < numeric_limits<double>::max()) {
+            checkpoint.bestRoute.assign(globalRoute.begin(), globalRoute.end());
+        }
+        checkpoint.progressBest = termination.progressBest();
+        checkpoint.lastImprovement = termination.lastImprovement();
+        checkpoint.rng = generationRng;
+        checkpointer.save(population, checkpoint);
+    };
+
+    telemetry.start(firstGeneration);
+    for (int generation = firstGeneration;; ++generation) {
+        // The last epoch's migrants replace the worst tours of this island
+        if (numIslands > 1 && generation > firstGeneration && generation % shared.migrationInterval == 0) {
+            double migrantLength;
+            for (int m = 0; m < shared.numMigrants; ++m) {
+                bool received;
+                while (!(received = incoming.receive(migrant.data(), migrantLength)) && shared.stop.reason() == StopReason::None) {
+                    this_thread::yield();
+                }
+                if (!received) {
+                    break;
+                }
+                int worst = static_cast<int>(max_element(population.lengths(), population.lengths() + islandSize) - population.lengths());
+                if (migrantLength < population.length(worst)) {
+                    copy(migrant.begin(), migrant.end(), population[worst]);
+                    population.length(worst) = migrantLength;
+                    if (hashes.enabled()) {
+                        hashes[worst] = tourHash(population[worst], numCities);
+                    }
+                }
             }
-            child[i] = parent2[currentIndex];
-            currentIndex = (currentIndex + 1) % numCities;
+            telemetry.lap(Phase::Migration);
         }
-    }
 
-    return child;
-}
+        // Selection reads the cached lengths in place and orders only the elite cut
+        const Rng generationRng = rng;
+        selector.prepare(population.lengths(), rng);
 
-// Function for mutation of a route
-void mutate(vector<int>& route, double mutationRate) {
-    int numCities = route.size();
-    random_device rd;
-    mt19937 g(rd());
-    uniform_real_distribution<double> dist(0.0, 1.0);
-    for (int i = 0; i < numCities; ++i) {
-        if (dist(g) < mutationRate) {
-            int j = rand() % numCities;
-            swap(route[i], route[j]);
+        // Publishing costs one relaxed load unless this island holds a new global best
+        const int best = selector.best();
+        if (population.length(best) < shared.globalBest.distance()) {
+            shared.globalBest.offer(population[best], population.length(best));
+            shared.targetTimer.update(population.length(best));
         }
-    }
-}
-
-mutex mtx;
-
-// Define a function for the GA process
-void geneticAlgorithm(vector<City>& cities, int populationSize, int numGenerations, double mutationRate, vector<int>& bestRoute, double& bestDistance, int threadId, queue<vector<int>>& taskQueue, mutex& taskMutex, condition_variable& workAvailable) {
-    int numCities = cities.size();
-
-    while (true) {
-        vector<int> task;
-
-        {
-            unique_lock<mutex> lock(taskMutex);
-            if (taskQueue.empty()) {
-                return;
+        const bool traced = telemetry.due(generation);
+        const bool measured = termination.measuresDiversity(generation);
+        const GenerationStats stats = traced || measured ? generationStats(population, best, statsScratch) : GenerationStats();
+
+        // Stop conditions are checked against the global best and the evaluations of all islands
+        StopReason reason = termination.checkClock();
+        if (reason == StopReason::None && shared.stop.reason() == StopReason::None) {
+            bool allCollapsed = false;
+            if (measured) {
+                const bool now = termination.diversityCollapsed(stats.diversity);
+                allCollapsed = shared.stop.updateCollapsed(collapsed, now);
+                collapsed = now;
             }
-
-            task = taskQueue.front();
-            taskQueue.pop();
+            reason = termination.checkProgress(generation, shared.globalBest.distance(), evaluations, allCollapsed);
+        }
+        if (reason != StopReason::None) {
+            shared.stop.request(reason);
+        }
+        if (termination.generationLimit(generation) || shared.stop.reason() != StopReason::None) {
+            if (telemetry.enabled()) {
+                telemetry.record(generation, traced || measured ? stats : generationStats(population, best, statsScratch));
+            }
+            shared.stop.finished(generation);
+            saveCheckpoint(generation, generationRng);
+            shared.hashStats[island].add(fitnessCache);
+            shared.hashStats[island].duplicates = hashes.duplicates();
+            return;
+        }
+        if (checkpointer.due(generation, firstGeneration)) {
+            saveCheckpoint(generation, generationRng);
+        }
+        telemetry.lap(Phase::Selection);
+
+        if (numIslands > 1 && generation % shared.migrationInterval == shared.migrationInterval - 1) {
+            // A full channel means the next island is an epoch behind; wait rather than drop
+            for (int m = 0; m < shared.numMigrants; ++m) {
+                const int migrantSlot = selector.ranked()[m];
+                while (!outgoing.send(population[migrantSlot], population.length(migrantSlot)) && shared.stop.reason() == StopReason::None) {
+                    this_thread::yield();
+                }
+            }
+            telemetry.lap(Phase::Migration);
         }
 
-
-        for (int generation = 0; generation < numGenerations; ++generation) {
-            // Perform GA operations on the task
-
-            // Crossover
-            vector<int> child = crossover(task, generateRandomRoute(numCities));
-
-            // Mutation
-            mutate(child, mutationRate);
-
-            // Update best route and distance if needed
-            double childDistance = calculateTotalDistance(child, cities);
-            mtx.lock();
-            if (childDistance < bestDistance) {
-                bestRoute = child;
-                bestDistance = childDistance;
+        // Elitism, then offspring from selected parents as in the serial program
+        for (int e = 0; e < selector.numElites(); ++e) {
+            population.carryOver(selector.ranked()[e], e);
+            if (hashes.enabled()) {
+                hashes.carryOver(selector.ranked()[e], e);
+            }
+            if (shouldImprove(shared.localSearch, shared.localSearchRate, e, islandSize, rng)) {
+                telemetry.lap(Phase::Selection);
+                population.nextLength(e) += localSearch.improve(population.next(e), numCities, shared.neighbors, shared.distance);
+                if (hashes.enabled()) {
+                    hashes.next(e) = tourHash(population.next(e), numCities);
+                }
+                telemetry.lap(Phase::LocalSearch);
             }
-            mtx.unlock();
+        }
+        telemetry.lap(Phase::Selection);
+        for (int i = selector.numElites(); i < islandSize; ++i) {
+            int parent1, parent2;
+            selector.parents(i, rng, parent1, parent2);
+            telemetry.lap(Phase::Selection);
+            if (rng.chance(shared.crossoverRate)) {
+                crossover(shared.crossoverType, population[parent1], population[parent2],
+                    population.next(i), numCities, crossoverScratch, rng);
+                telemetry.lap(Phase::Crossover);
+                population.nextLength(i) = hashes.enabled()
+                    ? scoreTour(shared.tourKernel, population.next(i), numCities, shared.distance, fitnessCache, hashes.next(i))
+                    : shared.tourKernel.tourLength(population.next(i), numCities, shared.distance);
+                telemetry.lap(Phase::Evaluation);
+            } else {
+                population.carryOver(parent1, i);
+                if (hashes.enabled()) {
+                    hashes.carryOver(parent1, i);
+                }
+            }
+            population.nextLength(i) += hashes.enabled()
+                ? mutate(shared.mutationType, population.next(i), numCities, shared.mutationRate, shared.distance, rng, hashes.next(i))
+                : mutate(shared.mutationType, population.next(i), numCities, shared.mutationRate, shared.distance, rng);
+            telemetry.lap(Phase::Mutation);
+            if (shouldImprove(shared.localSearch, shared.localSearchRate, i, islandSize, rng)) {
+                population.nextLength(i) += localSearch.improve(population.next(i), numCities, shared.neighbors, shared.distance,
+                    population[parent1], population[parent2]);
+                if (hashes.enabled()) {
+                    hashes.next(i) = tourHash(population.next(i), numCities);
+                }
+                telemetry.lap(Phase::LocalSearch);
+            }
+            if (fitnessCache.enabled()) {
+                fitnessCache.store(hashes.next(i), population.nextLength(i));
+            }
+        }
+        telemetry.countEvaluations(islandSize - selector.numElites());
+        bred += islandSize - selector.numElites();
+        evaluations = shared.stop.addEvaluations(islandSize - selector.numElites());
+        population.swapGenerations();
+        if (hashes.enabled()) {
+            hashes.swapGenerations();
+            if (shared.tourHash.dedup) {
+                hashes.replaceDuplicates(population, shared.distance, rng);
+            }
+        }
+        if (traced) {
+            telemetry.record(generation, stats);
         }
     }
 }
 
-int main() {
-    srand(42);
+int main(int argc, char* argv[]) {
+    Options options;
+    string error;
+    if (!parseOptions(argc, argv, options, error)) {
+        cerr << error << endl;
+        printUsage(cerr, argv[0]);
+        return 1;
+    }
+    if (options.showHelp) {
+        printUsage(cout, argv[0]);
+        return 0;
+    }
 
     const string LIGHT_BLUE = "\033[94m";
     const string GREEN = "\033[32m";
@@ -150,79 +313,143 @@ int main() {
     cout << GREEN + "           TRAVELING SALESMAN PROBLEM     " + RESET << endl;
     cout << GREEN + "================================================" + RESET << endl << endl;
 
-    ifstream inputFile("burma14.tsp");
-    if (!inputFile) {
-        cerr << "Failed to open input file." << endl;
+    // Record the start time
+    auto programStart = steady_clock::now();
+    Termination termination(options.stop, options.numGenerations, options.targetLength);
+    installInterruptHandler();
+
+    TspInstance instance;
+    bool fromCache = false;
+    auto loadStart = chrono::steady_clock::now();
+    if (!loadTspInstance(options.instancePath, instance, error, options.useCache, true, &fromCache)) {
+        cerr << error << endl;
         return 1;
     }
+    double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - loadStart).count();
 
-    string line;
-    vector<City> cities;
+    int numCities = instance.numCities();
 
-    // Skip lines until the problem data begins
-    while (inputFile >> line) {
-        if (line == "NODE_COORD_SECTION") {
-            break;
-        }
-    }
+    // Precompute the distance cache, the candidate neighbour lists and the SoA tour kernel
+    DistanceCache distances(instance);
+    NeighborLists neighbors(instance);
+    TourKernel tourKernel(instance, distances);
+    cout << LIGHT_BLUE << "Instance: " << instance.name << " (" << numCities << " cities, "
+        << edgeWeightTypeName(instance.weightType) << "), loaded in " << loadSeconds * 1000.0 << " ms"
+        << (fromCache ? " from cache" : "") << endl;
+    cout << "Distance cache: " << distanceLayoutName(distances.layout()) << ", "
+        << distances.memoryBytes() / 1048576.0 << " MB, built in " << distances.buildSeconds() * 1000.0 << " ms" << endl;
+    cout << "Neighbor lists: k = " << neighbors.k() << ", " << neighbors.memoryBytes() / 1048576.0
+        << " MB, built in " << neighbors.buildSeconds() * 1000.0 << " ms" << endl;
+    cout << "Tour kernel: " << tourKernel.description() << RESET << endl << endl;
+
+    int populationSize = options.populationSize;
+    int numThreads = options.numThreads > 0 ? options.numThreads : max(1, static_cast<int>(thread::hardware_concurrency()));
+    numThreads = min(numThreads, populationSize / 2);  // every island needs at least two tours
+
+    cout << LIGHT_BLUE + "Total number of threads: " << numThreads << " (one island each)" << endl;
 
-    // Read the coordinates from the TSP file
-    while (inputFile >> line) {
-        if (line == "EOF") {
-            break;
+    vector<int> bestRoute;
+    double bestDistance;
+    Seeder seeder(instance, neighbors, distances);
+    TargetTimer targetTimer(options.targetLength);
+    SharedStop stop(numThreads);
+    vector<Telemetry> telemetry(numThreads);
+    vector<TourHashStats> hashStats(numThreads);
+    for (int island = 0; island < numThreads; ++island) {
+        if (!telemetry[island].open(options.tracePath, options.traceFormat, options.traceInterval, "threading", island, numThreads, error)) {
+            cerr << error << endl;
+            return 1;
         }
-        City city;
-        inputFile >> city.id >> city.x >> city.y;
-        cities.push_back(city);
     }
 
-    int numCities = cities.size();
-    int populationSize = 100;
-    int numGenerations = 100;
-    double mutationRate = 0.01;
-    int numThreads = 6; 
+    // The population is split as evenly as possible; each island checkpoints its own shard
+    vector<int> islandSizes(numThreads);
+    CheckpointWriter checkpointWriter;
+    vector<Checkpointer> checkpointers;
+    for (int i = 0; i < numThreads; ++i) {
+        islandSizes[i] = populationSize / numThreads + (i < populationSize % numThreads ? 1 : 0);
+        checkpointers.emplace_back(options.checkpoint, checkpointWriter,
+            CheckpointId{ instance.name, numCities, options.seed, i, numThreads, islandSizes[i] });
+    }
+    const bool resume = options.checkpoint.resume && checkpointExists(checkpointers[0].path());
+    if (options.checkpoint.resume && !resume) {
+        cout << "No checkpoint at " << checkpointers[0].path() << ", starting a new run" << endl;
+    }
+    auto startTime = steady_clock::now();
+
+    int status = dispatchSpecialization(instance, distances, [&](auto index, const auto& distance) {
+        using Index = decltype(index);
+        using Distance = decay_t<decltype(distance)>;
+        cout << "Specialization: " << specializationName<Index, Distance>() << endl;
+
+        // Migration ring and lock-free global best; every island sends the same
+        // number of migrants, bounded by the smallest island
+        const int numMigrants = min(options.numMigrants, populationSize / numThreads);
+        vector<unique_ptr<MigrationChannel<Index>>> channels;
+        for (int i = 0; i < numThreads; ++i) {
+            channels.push_back(make_unique<MigrationChannel<Index>>(numCities, max(1, numMigrants * 2)));
+        }
+        GlobalBest<Index> globalBest(numCities);
+        IslandShared<Index, Distance> shared{ distances, distance, tourKernel, neighbors, seeder, options.seeding,
+            options.mutationRate, options.crossoverRate, options.selection, options.tournamentSize, options.numElites,
+            options.crossoverType, options.mutationType, options.localSearch, options.localSearchRate, options.seed,
+            options.migrationInterval, numMigrants, channels, globalBest, targetTimer, telemetry,
+            termination, stop, checkpointers, nullptr, options.tourHash, hashStats };
+
+        // Every island continues from its own shard; all of them must be there
+        vector<CheckpointFile> checkpoints(resume ? numThreads : 0);
+        for (int i = 0; i < static_cast<int>(checkpoints.size()); ++i) {
+            if (!checkpoints[i].open<Index>(checkpointers[i].path(), checkpointers[i].id(), error)) {
+                cerr << error << endl;
+                return 1;
+            }
+            printResumeReport(cout, checkpointers[i].path(), checkpoints[i].generation());
+        }
+        if (resume) {
+            shared.resume = &checkpoints;
+        } else {
+            cout << "Seeding: " << seedingName(options.seeding) << " (each island seeds its own tours)" << endl;
+        }
+        startTime = steady_clock::now();
+        targetTimer.restart();
 
-    vector<int> bestRoute;
-    double bestDistance = numeric_limits<double>::max();
+        // One persistent worker per island
+        vector<thread> threads;
+        for (int i = 0; i < numThreads; ++i) {
+            threads.emplace_back(geneticAlgorithm<Index, Distance>, cref(shared), i, islandSizes[i]);
+        }
 
-    cout << LIGHT_BLUE + "Total number of threads: " << numThreads << endl;
+        for (auto& thread : threads) {
+            thread.join();
+        }
 
-    // Create a work queue for tasks
-    queue<vector<int>> taskQueue;
-    mutex taskMutex;
-    condition_variable workAvailable;
+        vector<Index> route;
+        globalBest.snapshot(route, bestDistance);
+        bestRoute.assign(route.begin(), route.end());
+        return 0;
+    });
 
-    // Divide the population into tasks and enqueue them
-    vector<vector<int>> initialPopulation(populationSize);
-    for (int i = 0; i < populationSize; ++i) {
-        initialPopulation[i] = generateRandomRoute(numCities);
+    // End measuring time: the whole run, and the islands alone
+    auto endTime = steady_clock::now();
+    if (status != 0) {
+        return 1;
     }
-
-    // Enqueue tasks
-    for (int i = 0; i < populationSize; ++i) {
-        taskQueue.push(initialPopulation[i]);
+    if (!checkpointWriter.finish(error)) {
+        cerr << error << endl;
+        return 1;
     }
-
-    auto startTime = high_resolution_clock::now();
-
-    // Create and launch worker threads
-    vector<thread> threads;
-    for (int i = 0; i < numThreads; ++i) {
-        threads.emplace_back(geneticAlgorithm, ref(cities), populationSize, 
-            numGenerations, mutationRate, 
-            ref(bestRoute), ref(bestDistance), i, 
-            ref(taskQueue), ref(taskMutex), ref(workAvailable));
+    double duration = chrono::duration<double>(endTime - programStart).count();
+    double gaSeconds = chrono::duration<double>(endTime - startTime).count();
+    for (Telemetry& islandTelemetry : telemetry) {
+        if (!islandTelemetry.close(error)) {
+            cerr << error << endl;
+            return 1;
+        }
     }
-
-    for (auto& thread : threads) {
-        thread.join();
+    if (!options.tracePath.empty() && !mergeTraceParts(options.tracePath, options.traceFormat, numThreads, error)) {
+        cerr << error << endl;
+        return 1;
     }
-
-    // End measuring time
-    auto endTime = high_resolution_clock::now();
-
-    // Calculate elapsed time in seconds
-    auto duration = duration_cast<seconds>(endTime - startTime);
     cout << YELLOW + "\nResults:" + RESET << endl;
     cout << LIGHT_BLUE + "Best route:\n";
     for (int city : bestRoute) {
@@ -231,7 +458,24 @@ int main() {
     cout << endl;
     cout << RESET << "\n\n";
     cout << GREEN << "Total distance: " << bestDistance << endl;
-    cout << YELLOW + "Time taken by function: " << duration.count() << " seconds" << endl;
+    printTimeToTarget(cout, targetTimer);
+    const StopReason stopReason = stop.reason() != StopReason::None ? stop.reason() : StopReason::Generations;
+    printStopReason(cout, stopReason, stop.generations(), gaSeconds);
+    TourHashStats totalHashStats;
+    for (const TourHashStats& islandStats : hashStats) {
+        totalHashStats += islandStats;
+    }
+    printTourHashReport(cout, options.tourHash, totalHashStats);
+    cout << YELLOW + "Time taken by function: " << duration << " seconds" << endl;
+
+    if (!options.reportPath.empty()) {
+        RunReport report{ "threading", instance.name, numCities, numThreads, options.populationSize, stop.generations(),
+            options.seed, duration, gaSeconds, bestDistance, targetTimer.seconds(), stopReasonName(stopReason) };
+        if (!appendRunReport(options.reportPath, report, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+    }
 
     cout << GREEN + "\nThank you for using the Genetic Algorithm TSP Solver!" + RESET << endl;
     cout << GREEN + "===========================================" + RESET << endl;
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include "Random.h"
+
+// Migration topologies for the island model. Islands are numbered 0..n-1
+// (MPI ranks); epoch counts migrations, so the random topology can draw a
+// new pattern every time while all islands still agree on it.
+//
+//   ring    i sends to i + 1
+//   torus   islands on a near-square grid; i sends right and down
+//   random  a fresh random ring every epoch, derived from the master seed
+
+enum class Topology { Ring, Torus, Random };
+
+inline const char* topologyName(Topology topology) {
+    switch (topology) {
+    case Topology::Ring:   return "ring";
+    case Topology::Torus:  return "torus";
+    case Topology::Random: return "random";
+    }
+    return "unknown";
+}
+
+inline bool parseTopology(const std::string& name, Topology& topology) {
+    for (Topology candidate : { Topology::Ring, Topology::Torus, Topology::Random }) {
+        if (name == topologyName(candidate)) {
+            topology = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Grid used by the torus: the most square factorisation rows x columns of numIslands.
+inline void torusShape(int numIslands, int& rows, int& columns) {
+    rows = 1;
+    for (int r = 1; r * r <= numIslands; ++r) {
+        if (numIslands % r == 0) {
+            rows = r;
+        }
+    }
+    columns = numIslands / rows;
+}
+
+// Islands that `island` sends its migrants to in this epoch; never includes itself.
+inline std::vector<int> migrationTargets(Topology topology, int island, int numIslands, int epoch, uint64_t seed) {
+    std::vector<int> targets;
+    auto add = [&](int target) {
+        if (target != island && std::find(targets.begin(), targets.end(), target) == targets.end()) {
+            targets.push_back(target);
+        }
+    };
+    switch (topology) {
+    case Topology::Ring:
+        add((island + 1) % numIslands);
+        break;
+    case Topology::Torus: {
+        int rows, columns;
+        torusShape(numIslands, rows, columns);
+        const int row = island / columns;
+        const int column = island % columns;
+        add(row * columns + (column + 1) % columns);
+        add(((row + 1) % rows) * columns + column);
+        break;
+    }
+    case Topology::Random: {
+        std::vector<int> order(numIslands);
+        std::iota(order.begin(), order.end(), 0);
+        Rng rng(seed, 2, static_cast<uint64_t>(epoch));
+        rng.shuffle(order.data(), numIslands);
+        const int position = static_cast<int>(std::find(order.begin(), order.end(), island) - order.begin());
+        add(order[(position + 1) % numIslands]);
+        break;
+    }
+    }
+    return targets;
+}
+
+// Islands that send their migrants to `island` in this epoch, in ascending order.
+inline std::vector<int> migrationSources(Topology topology, int island, int numIslands, int epoch, uint64_t seed) {
+    std::vector<int> sources;
+    for (int source = 0; source < numIslands; ++source) {
+        if (source != island) {
+            std::vector<int> targets = migrationTargets(topology, source, numIslands, epoch, seed);
+            if (std::find(targets.begin(), targets.end(), island) != targets.end()) {
+                sources.push_back(source);
+            }
+        }
+    }
+    return sources;
+}
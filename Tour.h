@@ -0,0 +1,347 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+// Tour representations for local search, behind one interface:
+//
+//   size()              number of cities
+//   next(c), prev(c)    neighbours of city c in the current orientation
+//   between(a, b, c)    whether b lies on the path from a forward to c
+//   offset(a, b)        number of steps forward from a to b
+//   reverse(u, v)       reverses the path from u forward to v, or the rest of
+//                       the cycle if that is shorter; both give the same tour
+//
+// ArrayTour works in place on a flat route and a position index: queries are
+// O(1) and a reversal swaps up to n/2 cities. TwoLevelTour is the two-level
+// doubly-linked list of Fredman et al.: the tour is a ring of about sqrt(n)
+// segments, each with a reversal bit, so a reversal splits at most two
+// segments, flips the run of segments between them and merges small ones
+// again, all in O(sqrt n). LocalSearch picks the list above
+// LocalSearch::kTwoLevelMinCities and converts at the start and end of a call.
+//
+// Both reverse the same side and track which city the flat route would hold
+// at position 0, so they produce the same route, rotation included.
+
+template <typename Index>
+class ArrayTour {
+public:
+    ArrayTour(Index* route, int numCities, std::vector<int>& position)
+        : route_(route), numCities_(numCities), position_(position) {
+        position_.resize(numCities);
+        for (int i = 0; i < numCities; ++i) {
+            position_[route[i]] = i;
+        }
+    }
+
+    int size() const { return numCities_; }
+
+    int next(int city) const {
+        const int p = position_[city] + 1;
+        return route_[p == numCities_ ? 0 : p];
+    }
+
+    int prev(int city) const {
+        const int p = position_[city];
+        return route_[p == 0 ? numCities_ - 1 : p - 1];
+    }
+
+    int offset(int a, int b) const {
+        const int steps = position_[b] - position_[a];
+        return steps < 0 ? steps + numCities_ : steps;
+    }
+
+    bool between(int a, int b, int c) const { return offset(a, b) <= offset(a, c); }
+
+    void reverse(int u, int v) {
+        int i = position_[u], j = position_[v];
+        int length = offset(u, v) + 1;
+        if (2 * length > numCities_) {
+            const int newI = j + 1 == numCities_ ? 0 : j + 1;
+            const int newJ = i == 0 ? numCities_ - 1 : i - 1;
+            i = newI;
+            j = newJ;
+            length = numCities_ - length;
+        }
+        for (int s = 0; s < length / 2; ++s) {
+            const Index a = route_[i];
+            const Index b = route_[j];
+            route_[i] = b;
+            position_[b] = i;
+            route_[j] = a;
+            position_[a] = j;
+            if (++i == numCities_) {
+                i = 0;
+            }
+            if (--j < 0) {
+                j = numCities_ - 1;
+            }
+        }
+    }
+
+private:
+    Index* route_;
+    int numCities_;
+    std::vector<int>& position_;
+};
+
+class TwoLevelTour {
+public:
+    // Loads a flat route; keeps its allocations across calls.
+    template <typename Index>
+    void assign(const Index* route, int numCities) {
+        numCities_ = numCities;
+        groupSize_ = std::max(kMinGroupSize, static_cast<int>(std::sqrt(static_cast<double>(numCities))));
+        segmentOf_.resize(numCities);
+        index_.resize(numCities);
+        const int numSegments = (numCities + groupSize_ - 1) / groupSize_;
+        maxSegments_ = 2 * numSegments + 2;
+        segments_.resize(std::max(segments_.size(), static_cast<size_t>(numSegments)));
+        order_.clear();
+        free_.clear();
+        for (int s = static_cast<int>(segments_.size()) - 1; s >= numSegments; --s) {
+            free_.push_back(s);
+        }
+        for (int s = 0; s < numSegments; ++s) {
+            Segment& segment = segments_[s];
+            segment.cities.clear();
+            segment.reversed = false;
+            segment.rank = s;
+            for (int i = s * groupSize_; i < std::min(numCities, (s + 1) * groupSize_); ++i) {
+                place(route[i], s, static_cast<int>(segment.cities.size()));
+                segment.cities.push_back(route[i]);
+            }
+            order_.push_back(s);
+        }
+        first_ = numCities > 0 ? route[0] : 0;
+    }
+
+    // Writes the tour back as a flat route, from the city at position 0.
+    template <typename Index>
+    void copyTo(Index* route) const {
+        int out = 0;
+        const int start = segmentOf_[first_];
+        for (int step = 0; step <= static_cast<int>(order_.size()); ++step) {
+            const Segment& segment = segments_[order_[(segments_[start].rank + step) % order_.size()]];
+            const int size = static_cast<int>(segment.cities.size());
+            const int from = step == 0 ? position(first_) : 0;
+            const int to = step == static_cast<int>(order_.size()) ? position(first_) : size;
+            for (int p = from; p < to; ++p) {
+                route[out++] = static_cast<Index>(cityAt(segment, p));
+            }
+        }
+    }
+
+    int size() const { return numCities_; }
+    int numSegments() const { return static_cast<int>(order_.size()); }
+
+    int next(int city) const {
+        const Segment& segment = segments_[segmentOf_[city]];
+        const int p = position(city) + 1;
+        if (p < static_cast<int>(segment.cities.size())) {
+            return cityAt(segment, p);
+        }
+        return cityAt(segments_[order_[nextRank(segment.rank)]], 0);
+    }
+
+    int prev(int city) const {
+        const Segment& segment = segments_[segmentOf_[city]];
+        const int p = position(city);
+        if (p > 0) {
+            return cityAt(segment, p - 1);
+        }
+        const Segment& before = segments_[order_[prevRank(segment.rank)]];
+        return cityAt(before, static_cast<int>(before.cities.size()) - 1);
+    }
+
+    bool between(int a, int b, int c) const {
+        const int64_t ka = key(a), kb = key(b), kc = key(c);
+        return ka <= kc ? ka <= kb && kb <= kc : kb >= ka || kb <= kc;
+    }
+
+    int offset(int a, int b) const {
+        const Segment& from = segments_[segmentOf_[a]];
+        const Segment& to = segments_[segmentOf_[b]];
+        if (&from == &to && position(b) >= position(a)) {
+            return position(b) - position(a);
+        }
+        int steps = static_cast<int>(from.cities.size()) - position(a) + position(b);
+        for (int r = nextRank(from.rank); r != to.rank; r = nextRank(r)) {
+            steps += static_cast<int>(segments_[order_[r]].cities.size());
+        }
+        return steps;
+    }
+
+    void reverse(int u, int v) {
+        int length = offset(u, v) + 1;
+        if (length == numCities_) {
+            return;
+        }
+        if (2 * length > numCities_) {
+            const int newU = next(v);
+            v = prev(u);
+            u = newU;
+            length = numCities_ - length;
+        }
+        if (length < 2) {
+            return;
+        }
+        // Position 0 of the flat route stays where it is; if it is inside the path, its city is mirrored
+        if (between(u, first_, v)) {
+            first_ = advance(u, length - 1 - offset(u, first_));
+        }
+
+        const int after = next(v);
+        split(u);
+        split(after);
+        const int begin = segments_[segmentOf_[u]].rank;
+        const int end = segments_[segmentOf_[v]].rank;
+        const int count = (end - begin + numSegments()) % numSegments() + 1;
+        for (int t = 0; t < count / 2; ++t) {
+            std::swap(order_[(begin + t) % numSegments()], order_[(end - t + numSegments()) % numSegments()]);
+        }
+        for (int t = 0; t < count; ++t) {
+            Segment& segment = segments_[order_[(begin + t) % numSegments()]];
+            segment.reversed = !segment.reversed;
+            segment.rank = (begin + t) % numSegments();
+        }
+
+        // Merge small segments at both ends of the flipped run, and start over if they still pile up
+        mergeSmall(order_[prevRank(segments_[segmentOf_[v]].rank)]);
+        mergeSmall(segmentOf_[u]);
+        if (numSegments() > maxSegments_) {
+            rebuild();
+        }
+    }
+
+private:
+    static constexpr int kMinGroupSize = 8;
+
+    struct Segment {
+        std::vector<int> cities;  // internal order; the tour runs the other way if reversed
+        bool reversed = false;
+        int rank = 0;             // index in order_
+    };
+
+    int position(int city) const {
+        const Segment& segment = segments_[segmentOf_[city]];
+        return segment.reversed ? static_cast<int>(segment.cities.size()) - 1 - index_[city] : index_[city];
+    }
+
+    static int cityAt(const Segment& segment, int p) {
+        return segment.cities[segment.reversed ? segment.cities.size() - 1 - p : p];
+    }
+
+    int nextRank(int rank) const { return rank + 1 == numSegments() ? 0 : rank + 1; }
+    int prevRank(int rank) const { return rank == 0 ? numSegments() - 1 : rank - 1; }
+
+    int64_t key(int city) const {
+        return (static_cast<int64_t>(segments_[segmentOf_[city]].rank) << 32) | position(city);
+    }
+
+    void place(int city, int segment, int index) {
+        segmentOf_[city] = segment;
+        index_[city] = index;
+    }
+
+    // The city `steps` forward from `city`.
+    int advance(int city, int steps) const {
+        int rank = segments_[segmentOf_[city]].rank;
+        int p = position(city) + steps;
+        while (p >= static_cast<int>(segments_[order_[rank]].cities.size())) {
+            p -= static_cast<int>(segments_[order_[rank]].cities.size());
+            rank = nextRank(rank);
+        }
+        return cityAt(segments_[order_[rank]], p);
+    }
+
+    int newSegment() {
+        if (free_.empty()) {
+            segments_.emplace_back();
+            return static_cast<int>(segments_.size()) - 1;
+        }
+        const int s = free_.back();
+        free_.pop_back();
+        segments_[s].cities.clear();
+        segments_[s].reversed = false;
+        return s;
+    }
+
+    void renumber(int fromRank) {
+        for (int r = fromRank; r < numSegments(); ++r) {
+            segments_[order_[r]].rank = r;
+        }
+    }
+
+    // Makes `city` the first of its segment; the cities from it on move to a new segment right after.
+    void split(int city) {
+        const int s = segmentOf_[city];
+        const int p = position(city);
+        if (p == 0) {
+            return;
+        }
+        const int t = newSegment();
+        Segment& segment = segments_[s];
+        Segment& tail = segments_[t];
+        const int size = static_cast<int>(segment.cities.size());
+        for (int q = p; q < size; ++q) {
+            const int moved = cityAt(segment, q);
+            place(moved, t, q - p);
+            tail.cities.push_back(moved);
+        }
+        if (!segment.reversed) {
+            segment.cities.resize(p);
+        } else {
+            segment.cities.erase(segment.cities.begin(), segment.cities.begin() + (size - p));
+            for (int i = 0; i < p; ++i) {
+                index_[segment.cities[i]] = i;
+            }
+        }
+        order_.insert(order_.begin() + segment.rank + 1, t);
+        renumber(segment.rank + 1);
+    }
+
+    // Joins segment s with its successor if both together fit in a group.
+    void mergeSmall(int s) {
+        const int t = order_[nextRank(segments_[s].rank)];
+        if (t == s || segments_[s].cities.size() + segments_[t].cities.size() > static_cast<size_t>(groupSize_)) {
+            return;
+        }
+        Segment& segment = segments_[s];
+        Segment& tail = segments_[t];
+        if (segment.reversed) {
+            std::reverse(segment.cities.begin(), segment.cities.end());
+            segment.reversed = false;
+            for (int i = 0; i < static_cast<int>(segment.cities.size()); ++i) {
+                index_[segment.cities[i]] = i;
+            }
+        }
+        for (int q = 0; q < static_cast<int>(tail.cities.size()); ++q) {
+            const int moved = cityAt(tail, q);
+            place(moved, s, static_cast<int>(segment.cities.size()));
+            segment.cities.push_back(moved);
+        }
+        const int rank = tail.rank;
+        order_.erase(order_.begin() + rank);
+        free_.push_back(t);
+        renumber(rank);
+    }
+
+    void rebuild() {
+        std::vector<int> route(numCities_);
+        copyTo(route.data());
+        assign(route.data(), numCities_);
+    }
+
+    int numCities_ = 0;
+    int groupSize_ = kMinGroupSize;
+    int maxSegments_ = 0;
+    int first_ = 0;                 // city at position 0 of the flat route
+    std::vector<int> segmentOf_;    // per city
+    std::vector<int> index_;        // per city: index in its segment's cities
+    std::vector<Segment> segments_;
+    std::vector<int> order_;        // segments in tour order
+    std::vector<int> free_;         // unused entries of segments_
+};
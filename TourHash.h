@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <ostream>
+#include "Random.h"
+#include "Mutation.h"
+#include "Population.h"
+#include "TourKernel.h"
+
+// Tour hashing: duplicate detection and a fitness cache (--dedup, --fitness-cache).
+//
+// A tour's hash is the sum (mod 2^64) of a mixed hash of each undirected
+// edge, so every rotation of a tour and its reverse hash alike. The sum is
+// commutative, so a move changes it by the hashes of the edges it adds minus
+// those it removes: scored through HashedDistance, the mutation operators
+// return that change along with the length delta, and a mutated tour's hash
+// costs O(1) per move like its length. Only crossover children and tours
+// changed by local search are hashed from scratch.
+//
+// FitnessCache is a bounded, direct-mapped table from hash to length. Every
+// finished child is stored, and a crossover child is looked up before it is
+// scored, so once the population has converged and crossover mostly rebuilds
+// a parent, its distance lookups are skipped. Every edge weight is a rounded
+// TSPLIB integer, so lengths sum exactly in any order and a cached length is
+// the one a fresh evaluation would give.
+//
+// --dedup perturbs every tour that repeats a lower slot of the new generation
+// with a few random 2-opt moves (elites sit in the lowest slots and are kept),
+// so the population does not collapse into copies of one tour.
+
+struct TourHashOptions {
+    bool dedup = false;   // perturb repeated tours each generation
+    int cacheEntries = 0; // fitness cache size; 0: no cache
+
+    bool enabled() const { return dedup || cacheEntries > 0; }
+};
+
+// Mixed hash of the undirected edge {a, b}.
+inline uint64_t edgeHash(int a, int b) {
+    if (a > b) {
+        std::swap(a, b);
+    }
+    uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(a)) << 32 | static_cast<uint32_t>(b);
+    return splitMix64(key);
+}
+
+template <typename Index>
+uint64_t tourHash(const Index* route, int numCities) {
+    uint64_t hash = 0;
+    for (int i = 0; i + 1 < numCities; ++i) {
+        hash += edgeHash(route[i], route[i + 1]);
+    }
+    return numCities > 1 ? hash + edgeHash(route[numCities - 1], route[0]) : hash;
+}
+
+// A length and a hash change, summed together by the mutation operators.
+struct EdgeDelta {
+    double length = 0.0;
+    uint64_t hash = 0;
+
+    EdgeDelta& operator+=(const EdgeDelta& other) {
+        length += other.length;
+        hash += other.hash;
+        return *this;
+    }
+
+    EdgeDelta& operator-=(const EdgeDelta& other) {
+        length -= other.length;
+        hash -= other.hash;
+        return *this;
+    }
+};
+
+inline EdgeDelta operator+(EdgeDelta a, const EdgeDelta& b) { return a += b; }
+inline EdgeDelta operator-(EdgeDelta a, const EdgeDelta& b) { return a -= b; }
+
+// Scores an edge by its length and its hash.
+template <typename Distance>
+struct HashedDistance {
+    const Distance& distance;
+
+    EdgeDelta operator()(int a, int b) const { return { distance(a, b), edgeHash(a, b) }; }
+};
+
+// mutate() that also applies the change to the tour's hash; the length delta is
+// bit-for-bit the one the plain overload returns, and so is the random stream.
+template <typename Index, typename Distance>
+double mutate(MutationType type, Index* route, int numCities, double mutationRate, const Distance& distance, Rng& rng,
+    uint64_t& hash) {
+    const EdgeDelta delta = mutate(type, route, numCities, mutationRate, HashedDistance<Distance>{ distance }, rng);
+    hash += delta.hash;
+    return delta.length;
+}
+
+class FitnessCache {
+public:
+    FitnessCache() = default;
+
+    // capacity is rounded up to a power of two; 0 disables the cache.
+    explicit FitnessCache(int capacity) {
+        if (capacity > 0) {
+            size_t size = 1;
+            while (size < static_cast<size_t>(capacity)) {
+                size *= 2;
+            }
+            entries_.assign(size, Entry());
+            mask_ = size - 1;
+        }
+    }
+
+    bool enabled() const { return !entries_.empty(); }
+
+    bool lookup(uint64_t hash, double& length) {
+        if (entries_.empty()) {
+            return false;
+        }
+        ++lookups_;
+        const Entry& entry = entries_[hash & mask_];
+        if (entry.length < 0.0 || entry.hash != hash) {
+            return false;
+        }
+        ++hits_;
+        length = entry.length;
+        return true;
+    }
+
+    void store(uint64_t hash, double length) {
+        if (!entries_.empty()) {
+            entries_[hash & mask_] = { hash, length };
+        }
+    }
+
+    long long lookups() const { return lookups_; }
+    long long hits() const { return hits_; }
+
+private:
+    struct Entry {
+        uint64_t hash = 0;
+        double length = -1.0; // negative: empty
+    };
+
+    std::vector<Entry> entries_;
+    size_t mask_ = 0;
+    long long lookups_ = 0;
+    long long hits_ = 0;
+};
+
+// Length of a tour just bred by crossover, from the cache if it was seen before; sets its hash.
+template <typename Index, typename Distance>
+double scoreTour(const TourKernel& tourKernel, const Index* route, int numCities, const Distance& distance,
+    FitnessCache& cache, uint64_t& hash) {
+    hash = tourHash(route, numCities);
+    double length;
+    if (cache.lookup(hash, length)) {
+        return length;
+    }
+    return tourKernel.tourLength(route, numCities, distance);
+}
+
+// The hash of every tour of the current and the next generation, kept next to
+// the Population and swapped with it.
+class TourHashes {
+public:
+    TourHashes() = default;   // disabled
+    explicit TourHashes(int size) : current_(size, 0), next_(size, 0) {}
+
+    bool enabled() const { return !current_.empty(); }
+
+    uint64_t& operator[](int i) { return current_[i]; }
+    uint64_t& next(int i) { return next_[i]; }
+
+    void carryOver(int from, int to) { next_[to] = current_[from]; }
+    void swapGenerations() { current_.swap(next_); }
+
+    // Hashes every tour of the current generation from scratch, e.g. after seeding.
+    template <typename Index>
+    void compute(const Population<Index>& population) {
+        for (int i = 0; i < population.size(); ++i) {
+            current_[i] = tourHash(population[i], population.numCities());
+        }
+    }
+
+    // Perturbs each current tour that repeats one in a lower slot; returns how many.
+    template <typename Index, typename Distance>
+    int replaceDuplicates(Population<Index>& population, const Distance& distance, Rng& rng) {
+        const int numCities = population.numCities();
+        if (numCities < 5) {
+            return 0;
+        }
+        order_.clear();
+        for (int i = 0; i < population.size(); ++i) {
+            order_.emplace_back(current_[i], i);
+        }
+        std::sort(order_.begin(), order_.end());
+        int replaced = 0;
+        for (size_t k = 1; k < order_.size(); ++k) {
+            if (order_[k].first != order_[k - 1].first) {
+                continue;
+            }
+            const int slot = order_[k].second;
+            for (int move = 0; move < kPerturbationMoves; ++move) {
+                const int i = rng.below(numCities);
+                const int j = rng.below(numCities);
+                const EdgeDelta delta = inversionMove(population[slot], numCities, std::min(i, j), std::max(i, j),
+                    HashedDistance<Distance>{ distance });
+                population.length(slot) += delta.length;
+                current_[slot] += delta.hash;
+            }
+            ++replaced;
+        }
+        duplicates_ += replaced;
+        return replaced;
+    }
+
+    long long duplicates() const { return duplicates_; }
+
+private:
+    static constexpr int kPerturbationMoves = 3;
+
+    std::vector<uint64_t> current_;
+    std::vector<uint64_t> next_;
+    std::vector<std::pair<uint64_t, int>> order_;
+    long long duplicates_ = 0;
+};
+
+// Counters of one run, summed over workers.
+struct TourHashStats {
+    long long lookups = 0;
+    long long hits = 0;
+    long long duplicates = 0;
+
+    void add(const FitnessCache& cache) {
+        lookups += cache.lookups();
+        hits += cache.hits();
+    }
+
+    TourHashStats& operator+=(const TourHashStats& other) {
+        lookups += other.lookups;
+        hits += other.hits;
+        duplicates += other.duplicates;
+        return *this;
+    }
+};
+
+inline void printTourHashReport(std::ostream& out, const TourHashOptions& options, const TourHashStats& stats) {
+    if (!options.enabled()) {
+        return;
+    }
+    out << "Tour hashing:";
+    if (options.cacheEntries > 0) {
+        out << " fitness cache hit " << stats.hits << " of " << stats.lookups << " crossover children ("
+            << (stats.lookups > 0 ? 100.0 * stats.hits / stats.lookups : 0.0) << "%)";
+    }
+    if (options.dedup) {
+        out << (options.cacheEntries > 0 ? "," : "") << " " << stats.duplicates << " duplicate tours perturbed";
+    }
+    out << std::endl;
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include "TspInstance.h"
+#include "DistanceCache.h"
+#include "Population.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TSP_KERNEL_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Tour-length kernel on structure-of-arrays coordinates.
+//
+// The x and y coordinates are kept in two aligned arrays, and the edges of a
+// tour are scored several at a time by gathering the coordinates with AVX2
+// (4 lanes) or AVX-512 (8 lanes). The instruction set is picked once at run
+// time from the CPU; TSP_SIMD=scalar|avx2 forces a lower level.
+//
+// EUC_2D and CEIL_2D edges are rounded per edge exactly like
+// TspInstance::distance(). Every edge is then integral and the vector paths
+// return the same total as the scalar path; without rounding they would only
+// differ by summation order, which kTourKernelTolerance bounds. Other metrics
+// (ATT, GEO, EXPLICIT) are scored through the caller's distance functor, the
+// DistanceCache by default. Tours may use 16- or 32-bit city indices.
+
+constexpr double kTourKernelTolerance = 1e-10;
+
+enum class EdgeRounding { Nearest, Up };
+
+enum class SimdLevel { Scalar, Avx2, Avx512 };
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar: return "scalar";
+    case SimdLevel::Avx2:   return "avx2";
+    case SimdLevel::Avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+inline SimdLevel detectSimdLevel() {
+    SimdLevel level = SimdLevel::Scalar;
+#if defined(TSP_KERNEL_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+    if (maxLeaf >= 7 && osSavesYmm) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) {
+            level = SimdLevel::Avx2;
+        }
+        if ((info[1] & (1 << 16)) && (_xgetbv(0) & 0xe6) == 0xe6) {
+            level = SimdLevel::Avx512;
+        }
+    }
+#elif defined(TSP_KERNEL_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        level = SimdLevel::Avx2;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        level = SimdLevel::Avx512;
+    }
+#endif
+
+    if (const char* forced = std::getenv("TSP_SIMD")) {
+        if (std::strcmp(forced, "scalar") == 0) {
+            level = SimdLevel::Scalar;
+        } else if (std::strcmp(forced, "avx2") == 0 && level == SimdLevel::Avx512) {
+            level = SimdLevel::Avx2;
+        }
+    }
+    return level;
+}
+
+template <EdgeRounding Rounding>
+inline double roundEdge(double length) {
+    return Rounding == EdgeRounding::Nearest ? std::floor(length + 0.5) : std::ceil(length);
+}
+
+template <EdgeRounding Rounding, typename Index>
+inline double tourLengthScalar(const double* x, const double* y, const Index* route, int numCities) {
+    double totalDistance = 0.0;
+    for (int i = 0; i < numCities; ++i) {
+        int a = route[i], b = route[i + 1 == numCities ? 0 : i + 1];
+        double dx = x[a] - x[b], dy = y[a] - y[b];
+        totalDistance += roundEdge<Rounding>(std::sqrt(dx * dx + dy * dy));
+    }
+    return totalDistance;
+}
+
+#ifdef TSP_KERNEL_X86
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TSP_TARGET_AVX2 __attribute__((target("avx2")))
+#define TSP_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TSP_TARGET_AVX2
+#define TSP_TARGET_AVX512
+#endif
+
+// Tours may hold 16- or 32-bit city indices; the gathers take 32-bit lanes.
+TSP_TARGET_AVX2
+inline __m128i loadIndices4(const int* route) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(route)); }
+TSP_TARGET_AVX2
+inline __m128i loadIndices4(const uint32_t* route) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(route)); }
+TSP_TARGET_AVX2
+inline __m128i loadIndices4(const uint16_t* route) { return _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(route))); }
+
+TSP_TARGET_AVX512
+inline __m256i loadIndices8(const int* route) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(route)); }
+TSP_TARGET_AVX512
+inline __m256i loadIndices8(const uint32_t* route) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(route)); }
+TSP_TARGET_AVX512
+inline __m256i loadIndices8(const uint16_t* route) { return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(route))); }
+
+// Each chunk gathers the coordinates of route[i .. i+lanes-1] once; the edge
+// end points are the same values shifted by one lane, completed with the first
+// lane of the next chunk, so every city is gathered only once per tour.
+//
+// The masked and zero-masking forms of the intrinsics are used with every
+// lane enabled: the plain ones pass an undefined source vector, which GCC
+// reports as maybe-uninitialized under -Wall.
+
+template <EdgeRounding Rounding, typename Index>
+TSP_TARGET_AVX2
+inline double tourLengthAvx2(const double* x, const double* y, const Index* route, int numCities) {
+    const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    __m256d sum = _mm256_setzero_pd();
+    int i = 0;
+    if (numCities >= 8) {
+        __m128i index = loadIndices4(route);
+        __m256d fromX = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, index, all, 8);
+        __m256d fromY = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), y, index, all, 8);
+        for (; i + 8 <= numCities; i += 4) {
+            index = loadIndices4(route + i + 4);
+            __m256d nextX = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, index, all, 8);
+            __m256d nextY = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), y, index, all, 8);
+            __m256d toX = _mm256_blend_pd(_mm256_permute4x64_pd(fromX, 0x39), _mm256_permute4x64_pd(nextX, 0x00), 0x8);
+            __m256d toY = _mm256_blend_pd(_mm256_permute4x64_pd(fromY, 0x39), _mm256_permute4x64_pd(nextY, 0x00), 0x8);
+            __m256d dx = _mm256_sub_pd(fromX, toX);
+            __m256d dy = _mm256_sub_pd(fromY, toY);
+            __m256d length = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+            length = Rounding == EdgeRounding::Nearest ? _mm256_floor_pd(_mm256_add_pd(length, _mm256_set1_pd(0.5)))
+                                                       : _mm256_ceil_pd(length);
+            sum = _mm256_add_pd(sum, length);
+            fromX = nextX;
+            fromY = nextY;
+        }
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, sum);
+    double totalDistance = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < numCities; ++i) {
+        int a = route[i], b = route[i + 1 == numCities ? 0 : i + 1];
+        double dx = x[a] - x[b], dy = y[a] - y[b];
+        totalDistance += roundEdge<Rounding>(std::sqrt(dx * dx + dy * dy));
+    }
+    return totalDistance;
+}
+
+template <EdgeRounding Rounding, typename Index>
+TSP_TARGET_AVX512
+inline double tourLengthAvx512(const double* x, const double* y, const Index* route, int numCities) {
+    __m512d sum = _mm512_setzero_pd();
+    int i = 0;
+    if (numCities >= 16) {
+        __m256i index = loadIndices8(route);
+        __m512d fromX = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, index, x, 8);
+        __m512d fromY = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, index, y, 8);
+        for (; i + 16 <= numCities; i += 8) {
+            index = loadIndices8(route + i + 8);
+            __m512d nextX = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, index, x, 8);
+            __m512d nextY = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, index, y, 8);
+            __m512d toX = _mm512_castsi512_pd(_mm512_maskz_alignr_epi64(0xFF, _mm512_castpd_si512(nextX), _mm512_castpd_si512(fromX), 1));
+            __m512d toY = _mm512_castsi512_pd(_mm512_maskz_alignr_epi64(0xFF, _mm512_castpd_si512(nextY), _mm512_castpd_si512(fromY), 1));
+            __m512d dx = _mm512_sub_pd(fromX, toX);
+            __m512d dy = _mm512_sub_pd(fromY, toY);
+            __m512d length = _mm512_maskz_sqrt_pd(0xFF, _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)));
+            length = Rounding == EdgeRounding::Nearest
+                ? _mm512_maskz_roundscale_pd(0xFF, _mm512_add_pd(length, _mm512_set1_pd(0.5)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)
+                : _mm512_maskz_roundscale_pd(0xFF, length, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+            sum = _mm512_add_pd(sum, length);
+            fromX = nextX;
+            fromY = nextY;
+        }
+    }
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, sum);
+    double totalDistance = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    for (; i < numCities; ++i) {
+        int a = route[i], b = route[i + 1 == numCities ? 0 : i + 1];
+        double dx = x[a] - x[b], dy = y[a] - y[b];
+        totalDistance += roundEdge<Rounding>(std::sqrt(dx * dx + dy * dy));
+    }
+    return totalDistance;
+}
+
+#endif
+
+class TourKernel {
+public:
+    // Below this size the gathers cost more than they save.
+    static constexpr int kMinVectorCities = 32;
+
+    TourKernel(const TspInstance& instance, const DistanceCache& distances, SimdLevel level = detectSimdLevel())
+        : distances_(distances), numCities_(instance.numCities()), level_(level) {
+        vectorizable_ = instance.hasCoordinates()
+            && (instance.weightType == EdgeWeightType::Euc2D || instance.weightType == EdgeWeightType::Ceil2D);
+        rounding_ = instance.weightType == EdgeWeightType::Ceil2D ? EdgeRounding::Up : EdgeRounding::Nearest;
+
+        const size_t padded = (static_cast<size_t>(numCities_) + 7) / 8 * 8 + 8;
+        coordinates_ = static_cast<double*>(alignedAllocate(2 * padded * sizeof(double), kCacheLineBytes));
+        x_ = coordinates_;
+        y_ = coordinates_ + padded;
+        for (int i = 0; i < numCities_; ++i) {
+            x_[i] = instance.hasCoordinates() ? instance.cities[i].x : 0.0;
+            y_[i] = instance.hasCoordinates() ? instance.cities[i].y : 0.0;
+        }
+#ifndef TSP_KERNEL_X86
+        level_ = SimdLevel::Scalar;
+#endif
+    }
+
+    ~TourKernel() {
+        alignedFree(coordinates_);
+    }
+
+    TourKernel(const TourKernel&) = delete;
+    TourKernel& operator=(const TourKernel&) = delete;
+
+    SimdLevel level() const { return level_; }
+    bool vectorizable() const { return vectorizable_; }
+    const char* description() const { return vectorizable_ ? simdLevelName(level_) : "distance cache"; }
+    const double* x() const { return x_; }
+    const double* y() const { return y_; }
+
+    // Scores one tour; tours the SIMD paths cannot score go through `distance`,
+    // which a specialised caller passes as a branch-free view (Dispatch.h).
+    template <typename Index, typename Distance>
+    double tourLength(const Index* route, int numCities, const Distance& distance) const {
+        if (!vectorizable_) {
+            double totalDistance = distance(route[numCities - 1], route[0]);
+            for (int i = 0; i + 1 < numCities; ++i) {
+                totalDistance += distance(route[i], route[i + 1]);
+            }
+            return totalDistance;
+        }
+        return rounding_ == EdgeRounding::Nearest ? tourLength<EdgeRounding::Nearest>(route, numCities)
+                                                  : tourLength<EdgeRounding::Up>(route, numCities);
+    }
+
+    template <typename Index>
+    double tourLength(const Index* route, int numCities) const {
+        return tourLength(route, numCities, distances_);
+    }
+
+    template <EdgeRounding Rounding, typename Index>
+    double tourLength(const Index* route, int numCities) const {
+        if (numCities >= kMinVectorCities) {
+            switch (level_) {
+#ifdef TSP_KERNEL_X86
+            case SimdLevel::Avx512:
+                return tourLengthAvx512<Rounding>(x_, y_, route, numCities);
+            case SimdLevel::Avx2:
+                return tourLengthAvx2<Rounding>(x_, y_, route, numCities);
+#endif
+            default:
+                break;
+            }
+        }
+        return tourLengthScalar<Rounding>(x_, y_, route, numCities);
+    }
+
+    // Scores `count` tours stored `stride` indices apart.
+    template <typename Index, typename Distance>
+    void tourLengths(const Index* routes, size_t stride, int count, int numCities, double* lengths, const Distance& distance) const {
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static)
+#endif
+        for (int i = 0; i < count; ++i) {
+            lengths[i] = tourLength(routes + static_cast<size_t>(i) * stride, numCities, distance);
+        }
+    }
+
+    // Scores every tour of the current generation into its cached length.
+    template <typename Index, typename Distance>
+    void evaluate(Population<Index>& population, const Distance& distance) const {
+        tourLengths(population.data(), population.stride(), population.size(), population.numCities(), population.lengths(), distance);
+    }
+
+    template <typename Index>
+    void evaluate(Population<Index>& population) const {
+        evaluate(population, distances_);
+    }
+
+private:
+    const DistanceCache& distances_;
+    int numCities_;
+    SimdLevel level_;
+    bool vectorizable_;
+    EdgeRounding rounding_;
+    double* coordinates_;
+    double* x_;
+    double* y_;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include "City.h"
+#include "Metric.h"
+
+// A loaded TSPLIB instance and its edge-weight function.
+//
+// Distances follow the TSPLIB definitions and are therefore integral:
+//   EUC_2D    nint(euclidean distance)
+//   CEIL_2D   ceil(euclidean distance)
+//   ATT       pseudo-euclidean distance of the att instances
+//   GEO       great-circle distance on the TSPLIB idealised sphere
+//   EXPLICIT  weights given in the file (kept as a full symmetric matrix)
+
+enum class EdgeWeightType { Euc2D, Ceil2D, Att, Geo, Explicit };
+
+inline const char* edgeWeightTypeName(EdgeWeightType type) {
+    switch (type) {
+    case EdgeWeightType::Euc2D:    return "EUC_2D";
+    case EdgeWeightType::Ceil2D:   return "CEIL_2D";
+    case EdgeWeightType::Att:      return "ATT";
+    case EdgeWeightType::Geo:      return "GEO";
+    case EdgeWeightType::Explicit: return "EXPLICIT";
+    }
+    return "UNKNOWN";
+}
+
+inline bool parseEdgeWeightType(const std::string& name, EdgeWeightType& type) {
+    for (EdgeWeightType candidate : { EdgeWeightType::Euc2D, EdgeWeightType::Ceil2D, EdgeWeightType::Att,
+                                      EdgeWeightType::Geo, EdgeWeightType::Explicit }) {
+        if (name == edgeWeightTypeName(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// TSPLIB converts DDD.MM coordinates to radians with this truncated pi.
+inline double geoRadians(double coordinate) {
+    const double PI = 3.141592;
+    int degrees = static_cast<int>(coordinate);
+    double minutes = coordinate - degrees;
+    return PI * (degrees + 5.0 * minutes / 3.0) / 180.0;
+}
+
+struct TspInstance {
+    std::string name;
+    EdgeWeightType weightType = EdgeWeightType::Euc2D;
+    std::vector<City> cities;     // node or display coordinates; may be empty for EXPLICIT
+    std::vector<double> weights;  // EXPLICIT only: numCities x numCities, row-major
+
+    // GEO only: coordinates converted to radians once at load time.
+    std::vector<double> latitude, longitude;
+
+    int numCities() const { return static_cast<int>(explicitSize_ > 0 ? explicitSize_ : cities.size()); }
+    bool hasCoordinates() const { return !cities.empty(); }
+
+    // Must be called once the coordinates or weights are filled in.
+    void prepare(int numCities) {
+        explicitSize_ = weightType == EdgeWeightType::Explicit ? numCities : 0;
+        latitude.clear();
+        longitude.clear();
+        if (weightType == EdgeWeightType::Geo) {
+            latitude.resize(cities.size());
+            longitude.resize(cities.size());
+            for (size_t i = 0; i < cities.size(); ++i) {
+                latitude[i] = geoRadians(cities[i].x);
+                longitude[i] = geoRadians(cities[i].y);
+            }
+        }
+    }
+
+    double distance(int a, int b) const {
+        switch (weightType) {
+        case EdgeWeightType::Euc2D:    return Euc2DMetric{ cities.data() }(a, b);
+        case EdgeWeightType::Ceil2D:   return Ceil2DMetric{ cities.data() }(a, b);
+        case EdgeWeightType::Att:      return AttMetric{ cities.data() }(a, b);
+        case EdgeWeightType::Geo:      return GeoMetric{ latitude.data(), longitude.data() }(a, b);
+        case EdgeWeightType::Explicit: return ExplicitMetric{ weights.data(), explicitSize_ }(a, b);
+        }
+        return 0.0;
+    }
+
+private:
+    int explicitSize_ = 0;
+};
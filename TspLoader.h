@@ -0,0 +1,455 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "MappedFile.h"
+#include "TspInstance.h"
+
+// TSPLIB loader.
+//
+// The .tsp file is memory-mapped and parsed in place. The header is read
+// (NAME, TYPE, DIMENSION, EDGE_WEIGHT_TYPE, EDGE_WEIGHT_FORMAT), storage is
+// reserved from DIMENSION, and numbers go through a hand-rolled parser
+// instead of iostreams.
+//
+// After a successful parse a compact binary sidecar "<file>.cache" is written
+// (to a temporary file, then renamed). Later loads use it when its recorded
+// source size and hash of the source bytes still match; a modification time
+// would miss a same-size edit within its resolution. Errors are reported through
+// `error`, like the rest of the programs report them: a message and a false
+// return.
+
+class TsplibParser {
+public:
+    TsplibParser(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+    bool atEnd() {
+        skipWhitespace();
+        return p_ >= end_;
+    }
+
+    // Reads the next keyword, stopping at whitespace or ':'.
+    std::string keyword() {
+        skipWhitespace();
+        const char* start = p_;
+        while (p_ < end_ && !isSpace(*p_) && *p_ != ':') {
+            ++p_;
+        }
+        return std::string(start, p_);
+    }
+
+    // Reads the rest of the line after an optional ':' and trims it.
+    std::string lineValue() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t')) {
+            ++p_;
+        }
+        if (p_ < end_ && *p_ == ':') {
+            ++p_;
+        }
+        const char* start = p_;
+        while (p_ < end_ && *p_ != '\n' && *p_ != '\r') {
+            ++p_;
+        }
+        const char* stop = p_;
+        while (start < stop && isSpace(*start)) {
+            ++start;
+        }
+        while (stop > start && isSpace(stop[-1])) {
+            --stop;
+        }
+        return std::string(start, stop);
+    }
+
+    bool number(double& value) {
+        skipWhitespace();
+        const char* start = p_;
+        bool negative = false;
+        if (p_ < end_ && (*p_ == '-' || *p_ == '+')) {
+            negative = *p_++ == '-';
+        }
+
+        // Fast path: up to 19 significant digits and a small decimal exponent
+        // are converted exactly with one multiplication or division.
+        uint64_t mantissa = 0;
+        int digits = 0, exponent = 0;
+        bool any = false;
+        for (; p_ < end_ && isDigit(*p_); ++p_, any = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p_ - '0');
+                digits += mantissa != 0;
+            } else {
+                ++exponent;
+            }
+        }
+        if (p_ < end_ && *p_ == '.') {
+            for (++p_; p_ < end_ && isDigit(*p_); ++p_, any = true) {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + (*p_ - '0');
+                    digits += mantissa != 0;
+                    --exponent;
+                }
+            }
+        }
+        if (!any) {
+            p_ = start;
+            return false;
+        }
+        if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+            const char* mark = p_++;
+            bool negativeExponent = false;
+            if (p_ < end_ && (*p_ == '-' || *p_ == '+')) {
+                negativeExponent = *p_++ == '-';
+            }
+            if (p_ < end_ && isDigit(*p_)) {
+                int e = 0;
+                for (; p_ < end_ && isDigit(*p_); ++p_) {
+                    e = std::min(e * 10 + (*p_ - '0'), 100000);
+                }
+                exponent += negativeExponent ? -e : e;
+            } else {
+                p_ = mark;
+            }
+        }
+
+        static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        if (mantissa < (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+            double result = static_cast<double>(mantissa);
+            result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+            value = negative ? -result : result;
+            return true;
+        }
+
+        // Rare slow path: let the C library round it.
+        char buffer[128];
+        size_t length = std::min<size_t>(p_ - start, sizeof(buffer) - 1);
+        std::memcpy(buffer, start, length);
+        buffer[length] = '\0';
+        value = std::strtod(buffer, nullptr);
+        return true;
+    }
+
+private:
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    void skipWhitespace() {
+        while (p_ < end_ && isSpace(*p_)) {
+            ++p_;
+        }
+    }
+
+    const char* p_;
+    const char* end_;
+};
+
+// Fills the full symmetric matrix from an EDGE_WEIGHT_SECTION in any of the
+// TSPLIB matrix formats. Column-wise formats are the transposed row-wise ones.
+inline bool readExplicitWeights(TsplibParser& parser, const std::string& format, int n, std::vector<double>& weights, std::string& error) {
+    weights.assign(static_cast<size_t>(n) * n, 0.0);
+    auto set = [&](int i, int j, double w) {
+        weights[static_cast<size_t>(i) * n + j] = w;
+        weights[static_cast<size_t>(j) * n + i] = w;
+    };
+
+    bool upper, diagonal;
+    if (format == "FULL_MATRIX") {
+        for (size_t k = 0; k < weights.size(); ++k) {
+            if (!parser.number(weights[k])) {
+                error = "EDGE_WEIGHT_SECTION is shorter than DIMENSION^2 entries";
+                return false;
+            }
+        }
+        return true;
+    } else if (format == "UPPER_ROW" || format == "LOWER_COL") {
+        upper = true, diagonal = false;
+    } else if (format == "LOWER_ROW" || format == "UPPER_COL") {
+        upper = false, diagonal = false;
+    } else if (format == "UPPER_DIAG_ROW" || format == "LOWER_DIAG_COL") {
+        upper = true, diagonal = true;
+    } else if (format == "LOWER_DIAG_ROW" || format == "UPPER_DIAG_COL") {
+        upper = false, diagonal = true;
+    } else {
+        error = "Unsupported EDGE_WEIGHT_FORMAT: " + format;
+        return false;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        int first = upper ? (diagonal ? i : i + 1) : 0;
+        int last = upper ? n - 1 : (diagonal ? i : i - 1);
+        for (int j = first; j <= last; ++j) {
+            double w;
+            if (!parser.number(w)) {
+                error = "EDGE_WEIGHT_SECTION ended early";
+                return false;
+            }
+            set(i, j, w);
+        }
+    }
+    return true;
+}
+
+inline bool readCoordinates(TsplibParser& parser, int dimension, std::vector<City>& cities, std::string& error) {
+    cities.clear();
+    if (dimension > 0) {
+        cities.reserve(dimension);
+    }
+    while (dimension <= 0 || static_cast<int>(cities.size()) < dimension) {
+        double id, x, y;
+        if (!parser.number(id)) {
+            break;
+        }
+        if (!parser.number(x) || !parser.number(y)) {
+            error = "Malformed coordinate line for node " + std::to_string(static_cast<long long>(id));
+            return false;
+        }
+        City city;
+        city.id = static_cast<int>(id);
+        city.x = x;
+        city.y = y;
+        cities.push_back(city);
+    }
+    if (dimension > 0 && static_cast<int>(cities.size()) != dimension) {
+        error = "Expected " + std::to_string(dimension) + " coordinates, found " + std::to_string(cities.size());
+        return false;
+    }
+    return true;
+}
+
+inline bool parseTsplib(const char* begin, const char* end, TspInstance& instance, std::string& error) {
+    TsplibParser parser(begin, end);
+    int dimension = 0;
+    std::string weightFormat = "FULL_MATRIX";
+    bool haveWeightType = false;
+    instance = TspInstance();
+
+    while (!parser.atEnd()) {
+        std::string key = parser.keyword();
+        if (key == "EOF") {
+            break;
+        } else if (key == "NODE_COORD_SECTION" || key == "DISPLAY_DATA_SECTION") {
+            parser.lineValue();
+            if (!readCoordinates(parser, dimension, instance.cities, error)) {
+                return false;
+            }
+        } else if (key == "EDGE_WEIGHT_SECTION") {
+            parser.lineValue();
+            if (dimension <= 0) {
+                error = "EDGE_WEIGHT_SECTION before DIMENSION";
+                return false;
+            }
+            if (!readExplicitWeights(parser, weightFormat, dimension, instance.weights, error)) {
+                return false;
+            }
+        } else {
+            std::string value = parser.lineValue();
+            if (key == "NAME") {
+                instance.name = value;
+            } else if (key == "TYPE") {
+                if (value != "TSP") {
+                    error = "Only symmetric TSP instances are supported (TYPE: " + value + ")";
+                    return false;
+                }
+            } else if (key == "DIMENSION") {
+                dimension = std::atoi(value.c_str());
+            } else if (key == "EDGE_WEIGHT_TYPE") {
+                if (!parseEdgeWeightType(value, instance.weightType)) {
+                    error = "Unsupported EDGE_WEIGHT_TYPE: " + value;
+                    return false;
+                }
+                haveWeightType = true;
+            } else if (key == "EDGE_WEIGHT_FORMAT") {
+                weightFormat = value;
+            } else if (key.empty()) {
+                error = "Unexpected data in TSPLIB file";
+                return false;
+            }
+            // COMMENT, DISPLAY_DATA_TYPE, NODE_COORD_TYPE and other keys are informational.
+        }
+    }
+
+    if (!haveWeightType) {
+        instance.weightType = EdgeWeightType::Euc2D;
+    }
+    if (instance.weightType == EdgeWeightType::Explicit) {
+        if (instance.weights.empty()) {
+            error = "EXPLICIT instance without EDGE_WEIGHT_SECTION";
+            return false;
+        }
+    } else if (instance.cities.empty()) {
+        error = "No NODE_COORD_SECTION found";
+        return false;
+    }
+    instance.prepare(dimension > 0 ? dimension : static_cast<int>(instance.cities.size()));
+    return true;
+}
+
+// Binary sidecar cache layout (native endianness):
+//   BinaryCacheHeader, name bytes, numCoordinates x int32 id,
+//   numCoordinates x double x, numCoordinates x double y, numWeights x double
+struct BinaryCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t weightType;
+    int32_t numCities;
+    uint32_t nameLength;
+    uint64_t sourceSize;
+    uint64_t sourceHash;
+    uint64_t numCoordinates;
+    uint64_t numWeights;
+};
+
+constexpr char kBinaryCacheMagic[8] = { 'T', 'S', 'P', 'C', 'A', 'C', 'H', 'E' };
+constexpr uint32_t kBinaryCacheVersion = 2;
+
+// Hash of the source file, eight bytes per multiply, so checking a cache
+// costs a small fraction of parsing the file again.
+inline uint64_t sourceHash(const char* data, size_t size) {
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ size;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 31;
+    }
+    uint64_t tail = 0;
+    if (i < size) {
+        std::memcpy(&tail, data + i, size - i);
+    }
+    hash = (hash ^ tail) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 29);
+}
+
+inline std::string binaryCachePath(const std::string& path) {
+    return path + ".cache";
+}
+
+inline bool readBinaryCache(const std::string& cachePath, const MappedFile& source, TspInstance& instance) {
+    MappedFile cache;
+    if (!cache.open(cachePath) || cache.size() < sizeof(BinaryCacheHeader)) {
+        return false;
+    }
+    BinaryCacheHeader header;
+    std::memcpy(&header, cache.data(), sizeof(header));
+    if (std::memcmp(header.magic, kBinaryCacheMagic, sizeof(header.magic)) != 0 || header.version != kBinaryCacheVersion
+        || header.sourceSize != source.size() || header.sourceHash != sourceHash(source.data(), source.size())
+        || header.weightType > static_cast<uint32_t>(EdgeWeightType::Explicit)) {
+        return false;
+    }
+    const size_t expected = sizeof(header) + header.nameLength
+        + header.numCoordinates * (sizeof(int32_t) + 2 * sizeof(double)) + header.numWeights * sizeof(double);
+    if (cache.size() != expected) {
+        return false;
+    }
+
+    const char* p = cache.data() + sizeof(header);
+    instance = TspInstance();
+    instance.weightType = static_cast<EdgeWeightType>(header.weightType);
+    instance.name.assign(p, header.nameLength);
+    p += header.nameLength;
+
+    const size_t n = header.numCoordinates;
+    std::vector<int32_t> ids(n);
+    std::vector<double> xs(n), ys(n);
+    if (n > 0) {
+        std::memcpy(ids.data(), p, n * sizeof(int32_t));
+        std::memcpy(xs.data(), p + n * sizeof(int32_t), n * sizeof(double));
+        std::memcpy(ys.data(), p + n * (sizeof(int32_t) + sizeof(double)), n * sizeof(double));
+    }
+    p += n * (sizeof(int32_t) + 2 * sizeof(double));
+    instance.cities.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        instance.cities[i].id = ids[i];
+        instance.cities[i].x = xs[i];
+        instance.cities[i].y = ys[i];
+    }
+    instance.weights.resize(header.numWeights);
+    if (header.numWeights > 0) {
+        std::memcpy(instance.weights.data(), p, header.numWeights * sizeof(double));
+    }
+    instance.prepare(header.numCities);
+    return true;
+}
+
+// Best effort: a read-only directory simply means no cache.
+inline void writeBinaryCache(const std::string& cachePath, const MappedFile& source, const TspInstance& instance) {
+    BinaryCacheHeader header;
+    std::memcpy(header.magic, kBinaryCacheMagic, sizeof(header.magic));
+    header.version = kBinaryCacheVersion;
+    header.weightType = static_cast<uint32_t>(instance.weightType);
+    header.numCities = instance.numCities();
+    header.nameLength = static_cast<uint32_t>(instance.name.size());
+    header.sourceSize = source.size();
+    header.sourceHash = sourceHash(source.data(), source.size());
+    header.numCoordinates = instance.cities.size();
+    header.numWeights = instance.weights.size();
+
+    const size_t n = instance.cities.size();
+    std::vector<int32_t> ids(n);
+    std::vector<double> xs(n), ys(n);
+    for (size_t i = 0; i < n; ++i) {
+        ids[i] = instance.cities[i].id;
+        xs[i] = instance.cities[i].x;
+        ys[i] = instance.cities[i].y;
+    }
+
+    const std::string temporary = cachePath + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        return;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+        && std::fwrite(instance.name.data(), 1, instance.name.size(), file) == instance.name.size()
+        && std::fwrite(ids.data(), sizeof(int32_t), n, file) == n
+        && std::fwrite(xs.data(), sizeof(double), n, file) == n
+        && std::fwrite(ys.data(), sizeof(double), n, file) == n
+        && std::fwrite(instance.weights.data(), sizeof(double), instance.weights.size(), file) == instance.weights.size();
+    ok = std::fclose(file) == 0 && ok;
+#ifdef _WIN32
+    if (ok) {
+        std::remove(cachePath.c_str());
+    }
+#endif
+    if (!ok || std::rename(temporary.c_str(), cachePath.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+// Loads `path`, preferring an up-to-date binary cache. With writeCache set a
+// missing or stale cache is (re)written after parsing; in MPI runs only one
+// rank should write it.
+inline bool loadTspInstance(const std::string& path, TspInstance& instance, std::string& error,
+                            bool useCache = true, bool writeCache = true, bool* fromCache = nullptr) {
+    MappedFile source;
+    if (!source.open(path)) {
+        error = "Failed to open input file: " + path;
+        return false;
+    }
+    if (fromCache != nullptr) {
+        *fromCache = false;
+    }
+    if (useCache && readBinaryCache(binaryCachePath(path), source, instance)) {
+        if (fromCache != nullptr) {
+            *fromCache = true;
+        }
+        return true;
+    }
+    if (!parseTsplib(source.data(), source.data() + source.size(), instance, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    if (instance.numCities() < 1) {
+        error = path + ": instance has no cities";
+        return false;
+    }
+    if (useCache && writeCache) {
+        writeBinaryCache(binaryCachePath(path), source, instance);
+    }
+    return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include "Population.h"
+
+// Work-stealing pool for coarse, independent tasks such as whole instances.
+//
+// run(numTasks, task) deals the task numbers 0..numTasks-1 to the workers in
+// contiguous blocks, so neighbouring tasks start on the same worker. A worker
+// takes from the back of its own deque and, once that is empty, steals from
+// the front of another's, so workers that drew short tasks take over the rest
+// of a long block instead of idling. Each deque has its own mutex, padded to
+// a cache line: a task is milliseconds of work, so one uncontended lock per
+// task is noise, and workers only meet while stealing.
+//
+// runWhile(start, task) is for an open-ended stream of equal tasks, which has
+// no blocks to deal out: the workers draw indices from one shared counter
+// until a task says the stream is over, without ever waiting for each other.
+
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int numWorkers)
+        : numWorkers_(numWorkers < 1 ? 1 : numWorkers) {}
+
+    int numWorkers() const { return numWorkers_; }
+
+    // Calls task(worker, index) once for every index; the calling thread is worker 0.
+    template <typename Task>
+    void run(int numTasks, Task task) {
+        std::vector<std::unique_ptr<Queue>> queues;
+        for (int w = 0; w < numWorkers_; ++w) {
+            queues.push_back(std::make_unique<Queue>());
+            const int begin = static_cast<int>(static_cast<long long>(numTasks) * w / numWorkers_);
+            const int end = static_cast<int>(static_cast<long long>(numTasks) * (w + 1) / numWorkers_);
+            for (int t = end - 1; t >= begin; --t) {
+                queues[w]->tasks.push_back(t);
+            }
+        }
+
+        auto work = [&](int worker) {
+            int index;
+            while (take(queues, worker, index)) {
+                task(worker, index);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int w = 1; w < numWorkers_; ++w) {
+            threads.emplace_back(work, w);
+        }
+        work(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Calls start(worker) on every worker, then task(worker, index) for the
+    // indices 0, 1, 2, ... until a call returns false; every worker finishes
+    // the call it is in and stops, so every index below that one is done.
+    template <typename Start, typename Task>
+    void runWhile(Start start, Task task) {
+        std::atomic<long long> next{ 0 };
+        std::atomic<bool> over{ false };
+        auto work = [&](int worker) {
+            start(worker);
+            while (!over.load(std::memory_order_relaxed)) {
+                if (!task(worker, next.fetch_add(1, std::memory_order_relaxed))) {
+                    over.store(true, std::memory_order_relaxed);
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int w = 1; w < numWorkers_; ++w) {
+            threads.emplace_back(work, w);
+        }
+        work(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+private:
+    struct alignas(kCacheLineBytes) Queue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    // Own tasks first, then the oldest task of the next worker that has one.
+    bool take(std::vector<std::unique_ptr<Queue>>& queues, int worker, int& index) const {
+        for (int offset = 0; offset < numWorkers_; ++offset) {
+            Queue& queue = *queues[(worker + offset) % numWorkers_];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (offset == 0) {
+                index = queue.tasks.back();
+                queue.tasks.pop_back();
+            } else {
+                index = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    int numWorkers_;
+};
@@ -0,0 +1,338 @@
+#!/usr/bin/env python3
+"""End-to-end scaling runs and benchmark regression checks.
+
+  scaling.py run      runs Serial, OpenMP, Threading, MPI and the hybrid MPI +
+                      OpenMP build on each instance over a sweep of thread and
+                      rank counts; every run appends one JSON line (see
+                      RunReport.h) to --report
+  scaling.py report   builds speedup and parallel-efficiency tables from such
+                      a file
+  scaling.py compare  compares two `Benchmark --format json` outputs and exits
+                      with status 1 if a case got slower than --threshold
+  scaling.py resume   runs each program twice to --generations and once
+                      checkpointed at --split and resumed to --generations;
+                      exits with status 1 unless all three find the same tour
+
+Speedup is the median time of the program's own one-worker run divided by the
+median time on N workers; efficiency is speedup / N. The "vs serial" column
+divides the Serial program's median time instead. Times are the GA part of
+each run (seeding and generations), so loading the instance does not count.
+A hybrid run on N workers is N / --hybrid-threads ranks of --hybrid-threads
+threads each; its one-worker run is one rank with one thread.
+
+Examples:
+
+  scaling.py run --bin build --workers 1,2,4,8 --repeat 3 --report runs.jsonl
+  scaling.py report runs.jsonl --format csv --out scaling.csv
+  Benchmark --format json --out base.jsonl   (before the change)
+  Benchmark --format json --out new.jsonl    (after it)
+  scaling.py compare base.jsonl new.jsonl --threshold 0.05
+  scaling.py resume --bin build --workers 4 --extra '--population 40'
+"""
+
+import argparse
+import csv
+import json
+import os
+import statistics
+import shutil
+import subprocess
+import sys
+import tempfile
+
+PROGRAMS = ["serial", "openmp", "threading", "mpi", "hybrid"]
+EXECUTABLES = {"serial": "Serial", "openmp": "OpenMP", "threading": "Threading", "mpi": "MPI", "hybrid": "Hybrid"}
+INSTANCES = ["burma14.tsp", "pcb3038.tsp", "d5000.tsp"]
+
+
+def int_list(text):
+    values = [int(item) for item in text.split(",") if item]
+    if not values or min(values) < 1:
+        raise argparse.ArgumentTypeError("expected a comma-separated list of positive integers")
+    return values
+
+
+def name_list(allowed):
+    def parse(text):
+        names = [item for item in text.split(",") if item]
+        unknown = [name for name in names if name not in allowed]
+        if not names or unknown:
+            raise argparse.ArgumentTypeError("expected a comma-separated list of " + ", ".join(allowed))
+        return names
+    return parse
+
+
+def executable(directory, program):
+    path = os.path.join(directory, EXECUTABLES[program])
+    if os.name == "nt":
+        path += ".exe"
+    return path
+
+
+def layouts(program, workers, hybrid_threads):
+    """(ranks, threads) for each worker count the program runs on."""
+    if program == "serial":
+        return [(1, 1)]
+    if program == "mpi":
+        return [(n, 1) for n in workers]
+    if program == "hybrid":
+        return [(1, 1) if n == 1 else (n // hybrid_threads, hybrid_threads)
+                for n in workers if n == 1 or n % hybrid_threads == 0]
+    return [(1, n) for n in workers]
+
+
+def check_executables(args):
+    for program in args.programs:
+        path = executable(args.bin, program)
+        if not os.path.exists(path):
+            sys.exit("Missing executable " + path)
+
+
+def program_command(args, program, instance, ranks, threads, options):
+    command = [executable(args.bin, program), instance] + options
+    if program in ("mpi", "hybrid"):
+        command = args.mpirun.split() + ["-n", str(ranks)] + command
+    if program not in ("serial", "mpi"):
+        command += ["--threads", str(threads)]
+    return command
+
+
+def run_sweep(args):
+    check_executables(args)
+    extra = args.extra.split() if args.extra else []
+    for instance in args.instances:
+        for program in args.programs:
+            for ranks, threads in layouts(program, args.workers, args.hybrid_threads):
+                command = program_command(args, program, instance, ranks, threads, ["--report", args.report] + extra)
+                for _ in range(args.repeat):
+                    print(" ".join(command), file=sys.stderr)
+                    result = subprocess.run(command, stdout=subprocess.DEVNULL)
+                    if result.returncode != 0:
+                        sys.exit("Run failed with status %d: %s" % (result.returncode, " ".join(command)))
+    report(args)
+
+
+def load_lines(path):
+    rows = []
+    with open(path) as lines:
+        for number, line in enumerate(lines, 1):
+            line = line.strip()
+            if not line:
+                continue
+            try:
+                rows.append(json.loads(line))
+            except ValueError:
+                sys.exit("%s:%d: not a JSON line" % (path, number))
+    return rows
+
+
+def scaling_rows(runs):
+    # Median over repeats of the same program, instance and worker count
+    times = {}
+    best = {}
+    for run in runs:
+        key = (run["instance"], run["program"], run["workers"])
+        times.setdefault(key, []).append(run["ga_seconds"])
+        best[key] = min(best.get(key, run["best"]), run["best"])
+    medians = {key: statistics.median(values) for key, values in times.items()}
+
+    rows = []
+    order = {program: i for i, program in enumerate(PROGRAMS)}
+    for key in sorted(medians, key=lambda k: (k[0], order.get(k[1], len(PROGRAMS)), k[1], k[2])):
+        instance, program, workers = key
+        seconds = medians[key]
+        own = medians.get((instance, program, 1))
+        serial = medians.get((instance, "serial", 1))
+        speedup = own / seconds if own and seconds > 0 else None
+        rows.append({
+            "instance": instance,
+            "program": program,
+            "workers": workers,
+            "runs": len(times[key]),
+            "ga_seconds": seconds,
+            "best": best[key],
+            "speedup": speedup,
+            "efficiency": speedup / workers if speedup is not None else None,
+            "speedup_vs_serial": serial / seconds if serial and seconds > 0 else None,
+        })
+    return rows
+
+
+def number(value, digits):
+    return "" if value is None else "%.*f" % (digits, value)
+
+
+def write_rows(out, rows, columns, fmt):
+    if fmt == "csv":
+        writer = csv.DictWriter(out, fieldnames=columns, lineterminator="\n", extrasaction="ignore")
+        writer.writeheader()
+        writer.writerows(rows)
+    elif fmt == "json":
+        for row in rows:
+            out.write(json.dumps({column: row[column] for column in columns}) + "\n")
+
+
+def report(args):
+    rows = scaling_rows(load_lines(args.report))
+    columns = ["instance", "program", "workers", "runs", "ga_seconds", "best", "speedup", "efficiency", "speedup_vs_serial"]
+    out = open(args.out, "w") if args.out else sys.stdout
+    if args.format != "table":
+        write_rows(out, rows, columns, args.format)
+    else:
+        instance = None
+        for row in rows:
+            if row["instance"] != instance:
+                instance = row["instance"]
+                out.write("\n[%s]\n" % instance)
+                out.write("%-10s %8s %5s %12s %14s %9s %11s %10s\n" % (
+                    "program", "workers", "runs", "GA seconds", "best", "speedup", "efficiency", "vs serial"))
+            out.write("%-10s %8d %5d %12.4f %14.0f %9s %11s %10s\n" % (
+                row["program"], row["workers"], row["runs"], row["ga_seconds"], row["best"],
+                number(row["speedup"], 2), number(row["efficiency"], 2), number(row["speedup_vs_serial"], 2)))
+    if args.out:
+        out.close()
+
+
+def compare(args):
+    def index(path):
+        return {(m["section"], m["instance"], m["case"]): m for m in load_lines(path)}
+
+    baseline = index(args.baseline)
+    current = index(args.current)
+    rows = []
+    for key, now in current.items():
+        before = baseline.get(key)
+        if before is None or before["value"] <= 0:
+            continue
+        change = now["value"] / before["value"] - 1.0
+        rows.append({
+            "section": key[0], "instance": key[1], "case": key[2], "unit": now["unit"],
+            "baseline": before["value"], "current": now["value"], "change": change,
+            "regression": change > args.threshold,
+        })
+
+    columns = ["section", "instance", "case", "unit", "baseline", "current", "change", "regression"]
+    out = open(args.out, "w") if args.out else sys.stdout
+    if args.format != "table":
+        write_rows(out, rows, columns, args.format)
+    else:
+        out.write("%-10s %-14s %-34s %12s %12s %9s\n" % ("section", "instance", "case", "baseline", "current", "change"))
+        for row in rows:
+            out.write("%-10s %-14s %-34s %12.3f %12.3f %+8.1f%%%s\n" % (
+                row["section"], row["instance"], row["case"], row["baseline"], row["current"],
+                100.0 * row["change"], "  REGRESSION" if row["regression"] else ""))
+    if args.out:
+        out.close()
+
+    missing = len(set(baseline) - set(current))
+    if missing:
+        print("%d baseline cases have no current result" % missing, file=sys.stderr)
+    regressions = sum(row["regression"] for row in rows)
+    if regressions:
+        print("%d of %d cases slower than the baseline by more than %.0f%%"
+              % (regressions, len(rows), 100.0 * args.threshold), file=sys.stderr)
+        return 1
+    return 0
+
+
+def resume_check(args):
+    """Whether a checkpointed and resumed run ends like an uninterrupted one."""
+    check_executables(args)
+    extra = args.extra.split() if args.extra else []
+    directory = tempfile.mkdtemp(prefix="resume")
+    failures = 0
+    try:
+        print("%-10s %8s %14s %14s %14s" % ("program", "workers", "run", "repeat", "resumed"))
+        for program in args.programs:
+            layout = layouts(program, [args.workers], args.hybrid_threads)
+            if not layout:
+                print("%-10s skipped: --workers is not a multiple of --hybrid-threads" % program)
+                continue
+            ranks, threads = layout[-1]
+            checkpoint = os.path.join(directory, program + ".ckpt")
+            report_path = os.path.join(directory, program + ".jsonl")
+            runs = [["--generations", str(args.generations), "--report", report_path],
+                    ["--generations", str(args.generations), "--report", report_path],
+                    ["--generations", str(args.split), "--checkpoint", checkpoint],
+                    ["--generations", str(args.generations), "--checkpoint", checkpoint, "--resume",
+                     "--report", report_path]]
+            for options in runs:
+                command = program_command(args, program, args.instance, ranks, threads, options + extra)
+                print(" ".join(command), file=sys.stderr)
+                result = subprocess.run(command, stdout=subprocess.DEVNULL)
+                if result.returncode != 0:
+                    sys.exit("Run failed with status %d: %s" % (result.returncode, " ".join(command)))
+            best = [row["best"] for row in load_lines(report_path)]
+            same = len(set(best)) == 1
+            failures += not same
+            print("%-10s %8d %14.6g %14.6g %14.6g%s" % (program, ranks * threads, best[0], best[1], best[2],
+                                                       "" if same else "  DIFFERENT"))
+    finally:
+        shutil.rmtree(directory, ignore_errors=True)
+    return 1 if failures else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+    formats = ["table", "csv", "json"]
+
+    run = commands.add_parser("run", help="run the sweep, then print the report")
+    run.add_argument("--bin", default=".", help="directory of the Serial, OpenMP, Threading, MPI and Hybrid executables")
+    run.add_argument("--programs", type=name_list(PROGRAMS), default=PROGRAMS, help="default: all five")
+    run.add_argument("--instances", type=lambda text: text.split(","), default=INSTANCES,
+                     help="default: " + ",".join(INSTANCES))
+    run.add_argument("--workers", type=int_list, default=[1, 2, 4, 8], help="thread and rank counts (default 1,2,4,8)")
+    run.add_argument("--hybrid-threads", type=int, default=2, help="OpenMP threads per hybrid rank (default 2)")
+    run.add_argument("--repeat", type=int, default=3, help="runs per configuration; the median counts (default 3)")
+    run.add_argument("--mpirun", default="mpirun", help="launcher prefix for MPI, e.g. 'mpiexec' or 'mpirun --oversubscribe'")
+    run.add_argument("--extra", default="", help="options passed to every program, e.g. '--generations 500'")
+    run.add_argument("--report", default="runs.jsonl", help="JSON Lines file the runs append to")
+    run.add_argument("--format", choices=formats, default="table")
+    run.add_argument("--out", help="write the table to this file instead of stdout")
+
+    rep = commands.add_parser("report", help="speedup and efficiency tables from a run file")
+    rep.add_argument("report", help="JSON Lines file written with --report")
+    rep.add_argument("--format", choices=formats, default="table")
+    rep.add_argument("--out")
+
+    cmp = commands.add_parser("compare", help="compare two Benchmark JSON outputs")
+    cmp.add_argument("baseline")
+    cmp.add_argument("current")
+    cmp.add_argument("--threshold", type=float, default=0.05, help="allowed slowdown as a fraction (default 0.05)")
+    cmp.add_argument("--format", choices=formats, default="table")
+    cmp.add_argument("--out")
+
+    res = commands.add_parser("resume", help="check that resumed runs continue like uninterrupted ones")
+    res.add_argument("--bin", default=".", help="directory of the Serial, OpenMP, Threading, MPI and Hybrid executables")
+    res.add_argument("--programs", type=name_list(PROGRAMS), default=PROGRAMS, help="default: all five")
+    res.add_argument("--instance", default="pcb3038.tsp")
+    res.add_argument("--workers", type=int, default=4, help="threads, islands or ranks of every run (default 4)")
+    res.add_argument("--hybrid-threads", type=int, default=2, help="OpenMP threads per hybrid rank (default 2)")
+    res.add_argument("--generations", type=int, default=200, help="length of every run (default 200)")
+    res.add_argument("--split", type=int, default=125, help="generation of the checkpoint (default 125)")
+    res.add_argument("--mpirun", default="mpirun", help="launcher prefix for MPI, e.g. 'mpiexec' or 'mpirun --oversubscribe'")
+    res.add_argument("--extra", default="", help="options passed to every run, e.g. '--population 40'")
+
+    args = parser.parse_args()
+    if args.command == "run":
+        if args.repeat < 1:
+            parser.error("--repeat must be at least 1")
+        if args.hybrid_threads < 1:
+            parser.error("--hybrid-threads must be at least 1")
+        run_sweep(args)
+    elif args.command == "report":
+        report(args)
+    elif args.command == "resume":
+        if args.workers < 1 or args.hybrid_threads < 1:
+            parser.error("--workers and --hybrid-threads must be at least 1")
+        if not 0 < args.split < args.generations:
+            parser.error("--split must lie between 0 and --generations")
+        return resume_check(args)
+    else:
+        return compare(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())